@@ -0,0 +1,99 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <podofo/podofo.h>
+
+#include "CorpusGenerator.hpp"
+
+using namespace std;
+using namespace PoDoFo;
+
+namespace PDF
+{
+	static void appendContent(PdfObject *contents, const string &content, bool compress)
+	{
+		TVecFilters filters{};
+		if (compress)
+		{
+			filters.push_back(ePdfFilter_FlateDecode);
+		}
+
+		auto stream = contents->GetStream();
+		stream->BeginAppend(filters);
+		stream->Append(content.data(), content.size());
+		stream->EndAppend();
+	}
+
+	CorpusGenerator::CorpusGenerator(CorpusSpec spec)
+			: m_spec(std::move(spec))
+	{}
+
+	void CorpusGenerator::Generate(const boost::filesystem::path &path) const
+	{
+		PdfMemDocument document;
+		auto           fileName = path.generic_string();
+
+		for (int pageIndex{}; pageIndex < m_spec.pages; ++pageIndex)
+		{
+			auto   page = document.CreatePage(PdfPage::CreateStandardPageSize(ePdfPageSize_A4));
+			string content{};
+
+			auto &resources = page->GetResources()->GetDictionary();
+			if (not resources.HasKey("XObject"))
+			{
+				resources.AddKey("XObject", PdfDictionary());
+			}
+			auto &xobjects = resources.GetKey("XObject")->GetDictionary();
+
+			for (int index{}; index < m_spec.keywords; ++index)
+			{
+				PdfXObject xobject(PdfRect(0, 0, 200, 20), &document);
+				appendContent(xobject.GetContentsForAppending(), "0.9 g 0 0 200 20 re f\n", m_spec.compress);
+
+				auto name = "Kw" + to_string(index + 1);
+				xobjects.AddKey(PdfName(name), xobject.GetObject()->Reference());
+
+				content.append("q 1 0 0 1 40 ").append(to_string(40 + 30 * index)).append(" cm /")
+				       .append(name).append(" Do Q BT (").append(m_spec.keywordText).append(") Tj ET\n");
+			}
+
+			// Filler the matcher has to read through on every page
+			for (int line{}; line < 40; ++line)
+			{
+				content.append("BT 72 ").append(to_string(800 - 18 * line)).append(" Td (Lorem ipsum dolor sit amet) Tj ET\n");
+			}
+
+			appendContent(page->GetContentsForAppending(), content, m_spec.compress);
+
+			for (int index{}; index < m_spec.links; ++index)
+			{
+				auto      annot = page->CreateAnnotation(ePdfAnnotation_Link, PdfRect(40, 100 + 30 * index, 200, 20));
+				PdfAction action(ePdfAction_URI, &document);
+				action.SetURI(PdfString(m_spec.uri));
+				annot->SetAction(action);
+			}
+		}
+
+		if (not m_spec.xrefStream)
+		{
+			document.Write(fileName.data());
+			return;
+		}
+
+		PdfOutputDevice device(fileName.data());
+		PdfWriter       writer(document.GetObjects(), document.GetTrailer());
+		writer.SetPdfVersion(ePdfVersion_1_5);
+		writer.SetUseXRefStream(true);
+		writer.Write(&device);
+	}
+
+	const CorpusSpec &CorpusGenerator::GetSpec() const noexcept
+	{
+		return m_spec;
+	}
+}
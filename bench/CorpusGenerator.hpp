@@ -0,0 +1,58 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <string>
+#include <boost/filesystem.hpp>
+
+#include "pdf/Common.hpp"
+
+namespace PDF
+{
+	/// Shape of one synthetic document
+	struct CorpusSpec
+	{
+		int pages{10};
+
+		/// Link annotations with a uri action on every page
+		int links{2};
+
+		/// Form XObjects per page drawn under a name followed by the keyword text
+		int keywords{1};
+
+		/// Flate-compress page and XObject content streams
+		bool compress{true};
+
+		/// Write a cross-reference stream instead of a classic xref table
+		bool xrefStream{false};
+
+		std::string uri{"http://www.example.com/ad"};
+
+		std::string keywordText{"www.example.com"};
+	};
+
+	/**
+	 * Writes synthetic documents through PoDoFo, so benchmarks run on
+	 * files of a known shape. Content looks like what the cleaner removes:
+	 * /KwN Do draws a named XObject and the keyword text follows it.
+	 */
+	class CorpusGenerator
+	{
+	public:
+		explicit CorpusGenerator(CorpusSpec spec);
+
+		void Generate(const boost::filesystem::path &path) const;
+
+		NODISCARD
+		const CorpusSpec &GetSpec() const noexcept;
+
+	private:
+		CorpusSpec m_spec;
+	};
+}
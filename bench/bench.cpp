@@ -0,0 +1,324 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/program_options.hpp>
+
+#include "CorpusGenerator.hpp"
+#include "pdf/BatchCleaner.hpp"
+#include "pdf/Inspector.hpp"
+#include "pdf/Keyword.hpp"
+#include "pdf/SanitizeSession.hpp"
+
+using namespace PDF;
+using namespace PoDoFo;
+using namespace std;
+
+namespace bpo = boost::program_options;
+namespace bfs = boost::filesystem;
+
+struct Document
+{
+	bfs::path path;
+
+	string contents;
+
+	int pages;
+
+	/// Decoded content of every page
+	vector<string> pageContents;
+};
+
+struct Workload
+{
+	int pages{};
+
+	size_t bytes{};
+
+	/// Seconds spent in the measured part, the whole run when negative
+	double seconds{-1};
+};
+
+static string readFile(const bfs::path &path)
+{
+	bfs::ifstream stream(path, ios::binary);
+	return {istreambuf_iterator<char>(stream), istreambuf_iterator<char>()};
+}
+
+static string decodePage(PdfPage *page)
+{
+	string    buffer{};
+	PdfObject *contents = page->GetContents();
+
+	auto decode = [&buffer, contents](PdfObject *object)
+	{
+		if (object->IsReference())
+		{
+			object = contents->GetOwner()->GetObject(object->GetReference());
+		}
+
+		if (object and object->HasStream())
+		{
+			char     *data{};
+			pdf_long length{};
+
+			object->GetStream()->GetFilteredCopy(&data, &length);
+			buffer.append(data, static_cast<size_t>(length)).push_back('\n');
+			podofo_free(data);
+		}
+	};
+
+	if (not contents)
+	{
+		return buffer;
+	}
+
+	if (contents->IsArray())
+	{
+		for (auto &item : contents->GetArray())
+		{
+			decode(&item);
+		}
+	}
+	else
+	{
+		decode(contents);
+	}
+
+	return buffer;
+}
+
+static vector<Document> loadCorpus(const bfs::path &directory)
+{
+	vector<Document> documents{};
+
+	for (auto &entry : bfs::directory_iterator(directory))
+	{
+		if (entry.path().extension() != ".pdf")
+		{
+			continue;
+		}
+
+		Document document{entry.path(), readFile(entry.path()), 0, {}};
+		PdfMemDocument pdf;
+		pdf.LoadFromBuffer(document.contents.data(), static_cast<long>(document.contents.size()));
+
+		document.pages = pdf.GetPageCount();
+		for (int index{}; index < document.pages; ++index)
+		{
+			document.pageContents.push_back(decodePage(pdf.GetPage(index)));
+		}
+
+		documents.push_back(std::move(document));
+	}
+
+	sort(documents.begin(), documents.end(),
+	     [](const Document &a, const Document &b) { return a.path < b.path; });
+	return documents;
+}
+
+/// Runs body iterations times and prints the median run
+static void report(const string &name, int iterations, const function<Workload()> &body)
+{
+	vector<double> seconds{};
+	Workload       workload{};
+
+	for (int run{}; run < iterations; ++run)
+	{
+		auto start = chrono::steady_clock::now();
+		workload = body();
+		auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		seconds.push_back(workload.seconds < 0 ? elapsed : workload.seconds);
+	}
+
+	sort(seconds.begin(), seconds.end());
+	double median = seconds.at(seconds.size() / 2);
+	double megabytes = static_cast<double>(workload.bytes) / (1024.0 * 1024.0);
+
+	cout << left << setw(26) << name << right << fixed
+	     << setw(8) << workload.pages
+	     << setw(10) << setprecision(2) << megabytes
+	     << setw(12) << setprecision(4) << median
+	     << setw(12) << setprecision(1) << workload.pages / median
+	     << setw(10) << setprecision(2) << megabytes / median << endl;
+}
+
+int main(int argc, char **argv)
+{
+	string                  corpus{};
+	string                  uri{};
+	int                     iterations{};
+	int                     files{};
+	int                     jobs{};
+	CorpusSpec              spec{};
+	bpo::options_description description("Measures matching, deletion, whole-file cleaning and pipeline throughput");
+
+	description.add_options()
+			           ("help,h", "Print help info")
+			           ("corpus,d", bpo::value(&corpus), "Directory of PDF files, generated when not given")
+			           ("uri,u", bpo::value(&uri)->default_value("example\\.com"), "Uri regex to delete")
+			           ("iterations,i", bpo::value(&iterations)->default_value(5), "Runs per benchmark")
+			           ("files,f", bpo::value(&files)->default_value(8), "Documents of a generated corpus")
+			           ("jobs,j", bpo::value(&jobs)->default_value(0),
+			            "Threads cleaning documents in the pipeline, the core count when 0")
+			           ("pages,n", bpo::value(&spec.pages)->default_value(50), "Pages of a generated document")
+			           ("compress,c", bpo::value(&spec.compress)->default_value(spec.compress),
+			            "Compress the streams of a generated corpus")
+			           ("xref-stream,x", bpo::value(&spec.xrefStream)->implicit_value(true),
+			            "Write generated documents with a cross-reference stream");
+
+	try
+	{
+		bpo::variables_map variables;
+		store(parse_command_line(argc, argv, description), variables);
+		notify(variables);
+
+		if (variables.count("help"))
+		{
+			description.print(cout);
+			return 0;
+		}
+
+		auto workDir = bfs::temp_directory_path() / bfs::unique_path("pdfsanitizer-bench-%%%%%%%%");
+		bfs::create_directories(workDir / "out");
+
+		if (corpus.empty())
+		{
+			corpus = (workDir / "corpus").generic_string();
+			bfs::create_directories(corpus);
+
+			CorpusGenerator generator(spec);
+			for (int index{}; index < files; ++index)
+			{
+				generator.Generate(bfs::path(corpus) / ("_doc" + to_string(index + 1) + ".pdf"));
+			}
+		}
+
+		auto documents = loadCorpus(corpus);
+		auto patterns  = make_shared<const PatternSet>(vector<string>{uri});
+		auto &pattern  = patterns->GetCombined();
+
+		cout << left << setw(26) << "benchmark" << right
+		     << setw(8) << "pages" << setw(10) << "MB" << setw(12) << "median s"
+		     << setw(12) << "pages/s" << setw(10) << "MB/s" << endl;
+
+		report("KeywordMatcher::FindMatch", iterations, [&]
+		{
+			Workload workload{};
+			for (const auto &document : documents)
+			{
+				for (const auto &content : document.pageContents)
+				{
+					PdfContentsTokenizer tokenizer(content.data(), static_cast<long>(content.size()));
+					KeywordMatcher       matcher(pattern);
+					matcher.FindMatch(&tokenizer);
+
+					++workload.pages;
+					workload.bytes += content.size();
+				}
+			}
+			return workload;
+		});
+
+		// Parsing is left out of this one, only the search and removal are timed
+		report("Inspector::Delete", iterations, [&]
+		{
+			Workload workload{};
+			workload.seconds = 0;
+
+			for (const auto &document : documents)
+			{
+				Inspector inspector(document.path, document.contents, patterns);
+
+				auto start = chrono::steady_clock::now();
+				inspector.Delete(pattern);
+				workload.seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+				workload.pages += document.pages;
+				workload.bytes += document.contents.size();
+			}
+			return workload;
+		});
+
+		// Same settings as a default pdfsanitizer run, one document at a time
+		SessionOptions sessionOptions{};
+		sessionOptions.uris            = {uri};
+		sessionOptions.jobs            = 1;
+		sessionOptions.outputDirectory = workDir / "out";
+		sessionOptions.properties      = [](const bfs::path &) { return DocumentProperty("Title", "Author"); };
+		SanitizeSession session(sessionOptions);
+
+		report("SanitizeSession::Clean", iterations, [&]
+		{
+			Workload workload{};
+			for (const auto &document : documents)
+			{
+				auto result = session.Clean(document.path, session.GetOutputPath(document.path));
+				if (result.status == SanitizeResult::Status::Failed)
+				{
+					throw runtime_error(document.path.generic_string() + ": " + result.error);
+				}
+
+				workload.pages += document.pages;
+				workload.bytes += document.contents.size();
+			}
+			return workload;
+		});
+
+		// The stages of a pdfsanitizer run, copies are named with a prefix so
+		// that the outputs are written next to them and never read back
+		auto pipelineDir = workDir / "pipeline";
+		bfs::create_directories(pipelineDir);
+
+		for (size_t index{}; index < documents.size(); ++index)
+		{
+			bfs::copy_file(documents[index].path, pipelineDir / ("@doc" + to_string(index + 1) + ".pdf"));
+		}
+
+		vector<string> arguments{"pdfsanitizer", "--dir", pipelineDir.generic_string(), "--uri", uri,
+		                         "--prefix", "@", "--jobs", to_string(jobs)};
+		vector<char *> argumentValues{};
+
+		for (auto &argument : arguments)
+		{
+			argumentValues.push_back(argument.data());
+		}
+
+		FileHandler handler(static_cast<int>(argumentValues.size()), argumentValues.data());
+		handler.Parse();
+
+		report("BatchCleaner::Run", iterations, [&]
+		{
+			Workload workload{};
+			ostream  listing(nullptr);
+
+			BatchCleaner(handler, listing).Run();
+
+			for (const auto &document : documents)
+			{
+				workload.pages += document.pages;
+				workload.bytes += document.contents.size();
+			}
+			return workload;
+		});
+
+		bfs::remove_all(workDir);
+	}
+	catch (std::exception &e)
+	{
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
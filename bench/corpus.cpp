@@ -0,0 +1,72 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <iostream>
+#include <boost/program_options.hpp>
+
+#include "CorpusGenerator.hpp"
+
+using namespace PDF;
+using namespace std;
+
+namespace bpo = boost::program_options;
+namespace bfs = boost::filesystem;
+
+int main(int argc, char **argv)
+{
+	CorpusSpec              spec{};
+	string                  output{};
+	int                     files{};
+	bpo::options_description description("Writes synthetic PDF files for benchmarking");
+
+	description.add_options()
+			           ("help,h", "Print help info")
+			           ("out,o", bpo::value(&output)->default_value("corpus"), "Output directory")
+			           ("files,f", bpo::value(&files)->default_value(10), "Number of documents")
+			           ("pages,n", bpo::value(&spec.pages)->default_value(spec.pages), "Pages per document")
+			           ("links,l", bpo::value(&spec.links)->default_value(spec.links), "Link annotations per page")
+			           ("keywords,k", bpo::value(&spec.keywords)->default_value(spec.keywords),
+			            "Keyword-named XObjects per page")
+			           ("compress,c", bpo::value(&spec.compress)->default_value(spec.compress),
+			            "Flate-compress content streams")
+			           ("xref-stream,x", bpo::value(&spec.xrefStream)->implicit_value(true),
+			            "Write a cross-reference stream")
+			           ("uri,u", bpo::value(&spec.uri)->default_value(spec.uri), "Uri of the link annotations")
+			           ("keyword-text,t", bpo::value(&spec.keywordText)->default_value(spec.keywordText),
+			            "Text following each keyword name");
+
+	try
+	{
+		bpo::variables_map variables;
+		store(parse_command_line(argc, argv, description), variables);
+		notify(variables);
+
+		if (variables.count("help"))
+		{
+			description.print(cout);
+			return 0;
+		}
+
+		CorpusGenerator generator(spec);
+		bfs::create_directories(output);
+
+		for (int index{}; index < files; ++index)
+		{
+			auto path = bfs::path(output) / ("_doc" + to_string(index + 1) + ".pdf");
+			generator.Generate(path);
+			cout << path.generic_string() << endl;
+		}
+	}
+	catch (std::exception &e)
+	{
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,49 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <cstdlib>
+#include <new>
+
+#include "pdf/AllocationStats.hpp"
+
+// Linked into pdfsanitizer only, programs embedding the library keep their own allocator
+
+// The other forms of new and delete in libstdc++ end up in these two
+void *operator new(std::size_t size)
+{
+	PDF::AllocationStats::CountAllocation(size);
+
+	for (size = size ? size : 1;;)
+	{
+		if (auto pointer = std::malloc(size))
+		{
+			return pointer;
+		}
+
+		auto handler = std::get_new_handler();
+		if (not handler)
+		{
+			throw std::bad_alloc();
+		}
+		handler();
+	}
+}
+
+void operator delete(void *pointer) noexcept
+{
+	if (pointer)
+	{
+		PDF::AllocationStats::CountFree();
+	}
+	std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+	operator delete(pointer);
+}
@@ -1,9 +1,9 @@
-#include <thread>
 #include <iostream>
+#include <unistd.h>
 
-#include "pdf/DocumentProperty.hpp"
-#include "pdf/Inspector.hpp"
+#include "pdf/BatchCleaner.hpp"
 #include "pdf/FileHandler.hpp"
+#include "pdf/Server.hpp"
 
 using namespace PDF;
 using namespace std;
@@ -11,33 +11,7 @@ using namespace std;
 namespace bpo = boost::program_options;
 namespace bfs = boost::filesystem;
 
-vector<string> split(string &f, char by)
-{
-	size_t         begin{}, pos{};
-	vector<string> parts{};
-
-	while (begin < f.size())
-	{
-		if (pos == string::npos)
-		{
-			break;
-		}
-
-		pos = f.find(by, begin);
-
-		if (f.at(begin) == ' ')
-		{
-			++begin;
-		}
-
-		parts.push_back(f.substr(begin, pos - begin - 1));
-		begin = pos + 1;
-	}
-
-	return parts;
-}
-
-void cleanFiles(const FileHandler &, FileHandler::Path &, DocumentProperty && = {});
+void serve(const FileHandler &);
 
 void pdfCleaner(int, char **);
 
@@ -55,33 +29,9 @@ int main(int argc, char **argv)
 	return 0;
 }
 
-DocumentProperty createPropertyData(const FileHandler::Path &path, char prefix)
-{
-	auto       fileName = path.filename().generic_string();
-	DocumentProperty properties{};
-
-	fileName.erase(fileName.find(prefix), 1);
-	auto parts = split(fileName, '-');
-
-	if (!parts.empty())
-	{
-		if (parts.size() == 1)
-		{
-			properties = DocumentProperty("", parts.at(0));
-		}
-		else
-		{
-			properties = DocumentProperty(parts.at(1), parts.at(0));
-		}
-	}
-
-	return properties;
-}
-
 void pdfCleaner(int argc, char **argv)
 {
-	auto                     handler = FileHandler(argc, argv);
-	std::vector<std::thread> threads{};
+	auto handler = FileHandler(argc, argv);
 
 	if (!argc)
 	{
@@ -93,45 +43,39 @@ void pdfCleaner(int argc, char **argv)
 		handler.Parse();
 	}
 
-	auto files = handler.GetFiles();
-
-	for (auto &file : files)
+	if (not handler.GetOptions().serve.empty())
 	{
-		auto propData = createPropertyData(file, handler.GetOptions().prefix);
-		threads.emplace_back(&cleanFiles, std::ref(handler), std::ref(file), std::move(propData));
-		threads.back().join();
+		serve(handler);
+		return;
 	}
+
+	BatchCleaner(handler).Run();
 }
 
-void cleanFiles(const FileHandler &handler,
-                FileHandler::Path &filename,
-                DocumentProperty &&props)
+/// Keeps the patterns and workers warm across jobs instead of one process per batch
+void serve(const FileHandler &handler)
 {
-	string outputName = (handler.HasPrefix()
-	                     ? handler.RemovePrefix(filename).generic_string()
-	                     : filename.generic_string());
+	const auto     &options = handler.GetOptions();
+	SessionOptions sessionOptions{};
+
+	sessionOptions.uris      = options.uris;
+	sessionOptions.inspector = BatchCleaner::CreateInspectorOptions(handler);
+	sessionOptions.jobs      = options.jobs;
+	sessionOptions.pages     = options.pages;
+	sessionOptions.prefilter = options.prefilter;
+	sessionOptions.maxMemory = options.maxMemory;
+	sessionOptions.prefix    = options.prefix;
+	sessionOptions.replace   = options.replace;
+
+	Server server(sessionOptions);
 
-	auto inspector = make_unique<PDF::Inspector>(filename.generic_string());
-	bool done{};
-	cout << outputName << endl;
-	for (auto &u : handler.GetOptions().uris)
+	if (options.serve == "-")
 	{
-		inspector->Delete(u, handler.GetOptions().pageNum);
-		done = inspector->Done();
-		if (done)
-		{
-			break;
-		}
+		server.ServeStream(STDIN_FILENO, STDOUT_FILENO);
 	}
-
-	if (done)
+	else
 	{
-		inspector->SetDocumentProperties(props);
-		inspector->Write(outputName);
-
-		if (handler.HasPrefix() and handler.GetOptions().replace)
-		{
-			boost::filesystem::remove(filename);
-		}
+		cerr << "Serving on \'" << options.serve << '\'' << endl;
+		server.ServeSocket(options.serve);
 	}
 }
@@ -0,0 +1,71 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <atomic>
+
+#include "AllocationStats.hpp"
+
+namespace PDF
+{
+	static std::atomic<bool> g_counting{false};
+
+	// Trivial, so touching it from a replaced operator new never runs a constructor
+	static thread_local AllocationStats::Counters t_counters;
+
+	AllocationStats::Counters &AllocationStats::Counters::operator+=(const Counters &other) noexcept
+	{
+		allocations += other.allocations;
+		bytes += other.bytes;
+		frees += other.frees;
+		return *this;
+	}
+
+	void AllocationStats::Enable() noexcept
+	{
+		g_counting.store(true, std::memory_order_relaxed);
+	}
+
+	bool AllocationStats::IsEnabled() noexcept
+	{
+		return g_counting.load(std::memory_order_relaxed);
+	}
+
+	AllocationStats::Counters AllocationStats::GetThreadCounters() noexcept
+	{
+		return t_counters;
+	}
+
+	void AllocationStats::CountAllocation(std::size_t size) noexcept
+	{
+		if (g_counting.load(std::memory_order_relaxed))
+		{
+			++t_counters.allocations;
+			t_counters.bytes += size;
+		}
+	}
+
+	void AllocationStats::CountFree() noexcept
+	{
+		if (g_counting.load(std::memory_order_relaxed))
+		{
+			++t_counters.frees;
+		}
+	}
+
+	AllocationScope::AllocationScope(AllocationStats::Counters &counters) noexcept
+			: m_counters(counters),
+			  m_start(t_counters)
+	{}
+
+	AllocationScope::~AllocationScope()
+	{
+		m_counters.allocations += t_counters.allocations - m_start.allocations;
+		m_counters.bytes += t_counters.bytes - m_start.bytes;
+		m_counters.frees += t_counters.frees - m_start.frees;
+	}
+}
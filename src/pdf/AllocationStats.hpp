@@ -0,0 +1,73 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Common.hpp"
+
+namespace PDF
+{
+	/**
+	 * Per-thread counts of the global operator new and delete. The library
+	 * does not replace them itself, an executable that wants the counts
+	 * links a replacement calling CountAllocation() and CountFree(), as
+	 * pdfsanitizer does. PoDoFo allocates through them as well, so its
+	 * objects are counted with ours. Counting costs one relaxed load per
+	 * call until Enable() is called.
+	 */
+	class AllocationStats
+	{
+	public:
+		struct Counters
+		{
+			uint64_t allocations{};
+
+			uint64_t bytes{};
+
+			uint64_t frees{};
+
+			Counters &operator+=(const Counters &other) noexcept;
+		};
+
+		static void Enable() noexcept;
+
+		NODISCARD
+		static bool IsEnabled() noexcept;
+
+		/// Counts of the calling thread since counting was enabled
+		NODISCARD
+		static Counters GetThreadCounters() noexcept;
+
+		/// Called by a replaced operator new, does nothing until counting is enabled
+		static void CountAllocation(std::size_t size) noexcept;
+
+		/// Called by a replaced operator delete for a non-null pointer
+		static void CountFree() noexcept;
+	};
+
+	/// Adds what the calling thread allocates and frees while it lives to counters
+	class AllocationScope
+	{
+	public:
+		explicit AllocationScope(AllocationStats::Counters &counters) noexcept;
+
+		AllocationScope(const AllocationScope &) = delete;
+
+		AllocationScope &operator=(const AllocationScope &) = delete;
+
+		~AllocationScope();
+
+	private:
+		AllocationStats::Counters &m_counters;
+
+		AllocationStats::Counters m_start;
+	};
+}
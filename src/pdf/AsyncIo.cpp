@@ -0,0 +1,672 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "AsyncIo.hpp"
+#include "Trace.hpp"
+
+#ifdef PDFCLEANER_IO_URING
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#endif
+
+using namespace std;
+
+namespace PDF
+{
+#ifdef PDFCLEANER_IO_URING
+	/// Completion tag of the wake-up read, operations are tagged with their address
+	static constexpr uint64_t g_wakeupTag{0};
+
+	/// Largest single read or write, the length field of a submission is 32 bits
+	static constexpr size_t g_maxTransfer{1u << 30};
+
+	static int ioUringSetup(unsigned entries, io_uring_params *params)
+	{
+		return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+	}
+
+	static int ioUringEnter(int ring, unsigned toSubmit, unsigned minComplete, unsigned flags)
+	{
+		return static_cast<int>(::syscall(__NR_io_uring_enter, ring, toSubmit, minComplete, flags, nullptr, 0));
+	}
+
+	static int ioUringRegister(int ring, unsigned opcode, void *argument, unsigned count)
+	{
+		return static_cast<int>(::syscall(__NR_io_uring_register, ring, opcode, argument, count));
+	}
+
+	/// Queues shared with the kernel, touched by the completion thread only
+	struct AsyncIo::Ring
+	{
+		int descriptor{-1};
+
+		// Written by submitters to wake the completion thread up
+		int wakeup{-1};
+
+		uint64_t wakeupCount{};
+
+		void *submissionMap{MAP_FAILED};
+
+		size_t submissionSize{};
+
+		void *completionMap{MAP_FAILED};
+
+		size_t completionSize{};
+
+		io_uring_sqe *entries{static_cast<io_uring_sqe *>(MAP_FAILED)};
+
+		size_t entriesSize{};
+
+		unsigned *submissionHead{};
+
+		unsigned *submissionTail{};
+
+		unsigned submissionMask{};
+
+		unsigned *submissionArray{};
+
+		unsigned *completionHead{};
+
+		unsigned *completionTail{};
+
+		unsigned completionMask{};
+
+		io_uring_cqe *completions{};
+
+		// Next free submission slot, published to the kernel by Enter()
+		unsigned tail{};
+
+		~Ring()
+		{
+			if (entries != MAP_FAILED)
+			{
+				::munmap(entries, entriesSize);
+			}
+			if (completionMap != MAP_FAILED and completionMap != submissionMap)
+			{
+				::munmap(completionMap, completionSize);
+			}
+			if (submissionMap != MAP_FAILED)
+			{
+				::munmap(submissionMap, submissionSize);
+			}
+			if (wakeup >= 0)
+			{
+				::close(wakeup);
+			}
+			if (descriptor >= 0)
+			{
+				::close(descriptor);
+			}
+		}
+
+		bool Open(unsigned depth)
+		{
+			io_uring_params params{};
+
+			// One more slot for the wake-up read
+			descriptor = ioUringSetup(depth + 1, &params);
+			if (descriptor < 0 or not Supports())
+			{
+				return false;
+			}
+
+			submissionSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			completionSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+			bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+			if (single)
+			{
+				submissionSize = completionSize = max(submissionSize, completionSize);
+			}
+
+			submissionMap = ::mmap(nullptr, submissionSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			                       descriptor, IORING_OFF_SQ_RING);
+			if (submissionMap == MAP_FAILED)
+			{
+				return false;
+			}
+
+			completionMap = single ? submissionMap
+			                       : ::mmap(nullptr, completionSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			                                descriptor, IORING_OFF_CQ_RING);
+			if (completionMap == MAP_FAILED)
+			{
+				return false;
+			}
+
+			entriesSize = params.sq_entries * sizeof(io_uring_sqe);
+			entries     = static_cast<io_uring_sqe *>(::mmap(nullptr, entriesSize, PROT_READ | PROT_WRITE,
+			                                                 MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQES));
+			if (entries == MAP_FAILED)
+			{
+				return false;
+			}
+
+			auto submission = static_cast<char *>(submissionMap);
+			auto completion = static_cast<char *>(completionMap);
+
+			submissionHead  = reinterpret_cast<unsigned *>(submission + params.sq_off.head);
+			submissionTail  = reinterpret_cast<unsigned *>(submission + params.sq_off.tail);
+			submissionMask  = *reinterpret_cast<unsigned *>(submission + params.sq_off.ring_mask);
+			submissionArray = reinterpret_cast<unsigned *>(submission + params.sq_off.array);
+			completionHead  = reinterpret_cast<unsigned *>(completion + params.cq_off.head);
+			completionTail  = reinterpret_cast<unsigned *>(completion + params.cq_off.tail);
+			completionMask  = *reinterpret_cast<unsigned *>(completion + params.cq_off.ring_mask);
+			completions     = reinterpret_cast<io_uring_cqe *>(completion + params.cq_off.cqes);
+			tail            = *submissionTail;
+
+			wakeup = ::eventfd(0, EFD_CLOEXEC);
+			return wakeup >= 0;
+		}
+
+		/// Every operation the file chains use, renameat and unlinkat came last in Linux 5.11
+		bool Supports() const
+		{
+			constexpr unsigned opCount = 256;
+			vector<uint64_t>   buffer((sizeof(io_uring_probe) + opCount * sizeof(io_uring_probe_op)) / sizeof(uint64_t));
+			auto               probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+
+			if (ioUringRegister(descriptor, IORING_REGISTER_PROBE, probe, opCount) < 0)
+			{
+				return false;
+			}
+
+			for (unsigned op : {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_FSYNC,
+			                    IORING_OP_CLOSE, IORING_OP_RENAMEAT, IORING_OP_UNLINKAT})
+			{
+				if (op > probe->last_op or not (probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/// Next submission, passed to the kernel by the following Enter()
+		io_uring_sqe *Next(uint8_t opcode, uint64_t tag)
+		{
+			unsigned index = tail++ & submissionMask;
+			auto     entry = &entries[index];
+
+			memset(entry, 0, sizeof(*entry));
+			entry->opcode        = opcode;
+			entry->user_data     = tag;
+			submissionArray[index] = index;
+			return entry;
+		}
+
+		/// Submits everything queued in one call and waits for a completion
+		void Enter()
+		{
+			__atomic_store_n(submissionTail, tail, __ATOMIC_RELEASE);
+
+			auto queued = tail - __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+			if (ioUringEnter(descriptor, queued, 1, IORING_ENTER_GETEVENTS) < 0
+			    and errno != EINTR and errno != EAGAIN and errno != EBUSY)
+			{
+				throw system_error(errno, generic_category(), "io_uring_enter");
+			}
+		}
+
+		template<typename Handler>
+		void Reap(Handler handler)
+		{
+			unsigned head = *completionHead;
+			unsigned last = __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+
+			for (; head != last; ++head)
+			{
+				auto tag    = completions[head & completionMask].user_data;
+				auto result = completions[head & completionMask].res;
+
+				// The slot is given back before the handler queues the next step
+				__atomic_store_n(completionHead, head + 1, __ATOMIC_RELEASE);
+				handler(tag, result);
+			}
+		}
+
+		void ArmWakeup()
+		{
+			auto entry = Next(IORING_OP_READ, g_wakeupTag);
+			entry->fd   = wakeup;
+			entry->addr = reinterpret_cast<uintptr_t>(&wakeupCount);
+			entry->len  = sizeof(wakeupCount);
+		}
+
+		void Wake() const noexcept
+		{
+			uint64_t one = 1;
+			MAYBE_UNUSED auto written = ::write(wakeup, &one, sizeof(one));
+		}
+	};
+
+	struct AsyncIo::Operation
+	{
+		enum class Step
+		{
+			Open,
+			Read,
+			Write,
+			Sync,
+			Close,
+			Rename,
+			Unlink,
+			// Removes the temporary file of a failed write
+			Discard,
+			Done
+		};
+
+		Step step{Step::Open};
+
+		bool writing{};
+
+		bool sync{};
+
+		/// The file opened, the temporary one when there is one
+		string path;
+
+		/// Rename target, empty when path is the output itself
+		string output;
+
+		string remove;
+
+		string data;
+
+		size_t offset{};
+
+		int descriptor{-1};
+
+		/// First failure, later steps only clean up
+		error_code error;
+
+		ReadCallback onRead;
+
+		WriteCallback onWrite;
+
+		void Fail(int result)
+		{
+			if (not error)
+			{
+				error = error_code(-result, generic_category());
+			}
+		}
+	};
+
+	unique_ptr<AsyncIo> AsyncIo::Create(unsigned depth)
+	{
+		auto ring = make_unique<Ring>();
+
+		// Old kernels and sandboxes without io_uring get the blocking path
+		if (depth == 0 or not ring->Open(depth))
+		{
+			return nullptr;
+		}
+
+		return unique_ptr<AsyncIo>(new AsyncIo(std::move(ring), depth));
+	}
+
+	AsyncIo::AsyncIo(unique_ptr<Ring> ring, unsigned depth)
+			: m_ring(std::move(ring)),
+			  m_depth(depth),
+			  m_inFlight(),
+			  m_stopped(false),
+			  m_mutex(),
+			  m_completed(),
+			  m_pending(),
+			  m_thread()
+	{
+		m_thread = thread(&AsyncIo::Run, this);
+	}
+
+	AsyncIo::~AsyncIo()
+	{
+		{
+			lock_guard l(m_mutex);
+			m_stopped = true;
+		}
+		m_ring->Wake();
+		m_thread.join();
+	}
+
+	void AsyncIo::Read(const Path &path, ReadCallback callback)
+	{
+		auto operation = make_unique<Operation>();
+
+		operation->path   = path.native();
+		operation->onRead = std::move(callback);
+		Submit(std::move(operation));
+	}
+
+	void AsyncIo::Write(WriteRequest request, WriteCallback callback)
+	{
+		auto operation = make_unique<Operation>();
+
+		operation->writing = true;
+		operation->sync    = request.sync;
+		operation->data    = std::move(request.contents);
+		operation->remove  = request.remove.native();
+		operation->onWrite = std::move(callback);
+
+		if (request.temporary.empty())
+		{
+			operation->path = request.output.native();
+		}
+		else
+		{
+			operation->path   = request.temporary.native();
+			operation->output = request.output.native();
+		}
+		Submit(std::move(operation));
+	}
+
+	void AsyncIo::Wait()
+	{
+		unique_lock l(m_mutex);
+		m_completed.wait(l, [this] { return m_inFlight == 0; });
+	}
+
+	void AsyncIo::Submit(unique_ptr<Operation> operation)
+	{
+		bool wake;
+		{
+			unique_lock l(m_mutex);
+			m_completed.wait(l, [this] { return m_inFlight < m_depth; });
+
+			++m_inFlight;
+			// A non-empty list means a wake-up is already on its way
+			wake = m_pending.empty();
+			m_pending.push_back(std::move(operation));
+		}
+
+		if (wake)
+		{
+			m_ring->Wake();
+		}
+	}
+
+	void AsyncIo::Run()
+	{
+		vector<unique_ptr<Operation>> started{};
+
+		Trace::SetThreadName("io");
+		m_ring->ArmWakeup();
+
+		for (;;)
+		{
+			{
+				lock_guard l(m_mutex);
+				if (m_stopped and m_inFlight == 0)
+				{
+					break;
+				}
+				started.swap(m_pending);
+			}
+
+			for (auto &operation : started)
+			{
+				Start(operation.release());
+			}
+			started.clear();
+
+			// New files and the next steps of completed ones go in together
+			m_ring->Enter();
+			m_ring->Reap([this](uint64_t tag, int result)
+			             {
+				             if (tag == g_wakeupTag)
+				             {
+					             m_ring->ArmWakeup();
+					             return;
+				             }
+				             Advance(reinterpret_cast<Operation *>(tag), result);
+			             });
+		}
+	}
+
+	void AsyncIo::Start(Operation *operation)
+	{
+		auto tag = reinterpret_cast<uintptr_t>(operation);
+		auto &op = *operation;
+
+		switch (op.step)
+		{
+			case Operation::Step::Open:
+			{
+				auto entry = m_ring->Next(IORING_OP_OPENAT, tag);
+				entry->fd         = AT_FDCWD;
+				entry->addr       = reinterpret_cast<uintptr_t>(op.path.c_str());
+				entry->open_flags = op.writing ? O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC : O_RDONLY | O_CLOEXEC;
+				entry->len        = 0666;
+				break;
+			}
+			case Operation::Step::Read:
+			case Operation::Step::Write:
+			{
+				auto entry = m_ring->Next(op.writing ? IORING_OP_WRITE : IORING_OP_READ, tag);
+				entry->fd   = op.descriptor;
+				entry->addr = reinterpret_cast<uintptr_t>(op.data.data() + op.offset);
+				entry->len  = static_cast<uint32_t>(min(op.data.size() - op.offset, g_maxTransfer));
+				entry->off  = op.offset;
+				break;
+			}
+			case Operation::Step::Sync:
+				m_ring->Next(IORING_OP_FSYNC, tag)->fd = op.descriptor;
+				break;
+			case Operation::Step::Close:
+				m_ring->Next(IORING_OP_CLOSE, tag)->fd = op.descriptor;
+				break;
+			case Operation::Step::Rename:
+			{
+				auto entry = m_ring->Next(IORING_OP_RENAMEAT, tag);
+				entry->fd    = AT_FDCWD;
+				entry->addr  = reinterpret_cast<uintptr_t>(op.path.c_str());
+				entry->len   = static_cast<uint32_t>(AT_FDCWD);
+				entry->addr2 = reinterpret_cast<uintptr_t>(op.output.c_str());
+				break;
+			}
+			case Operation::Step::Unlink:
+			case Operation::Step::Discard:
+			{
+				auto entry = m_ring->Next(IORING_OP_UNLINKAT, tag);
+				entry->fd   = AT_FDCWD;
+				entry->addr = reinterpret_cast<uintptr_t>((op.step == Operation::Step::Unlink ? op.remove : op.path)
+						                                          .c_str());
+				break;
+			}
+			case Operation::Step::Done:
+				Finish(operation);
+				break;
+		}
+	}
+
+	void AsyncIo::Advance(Operation *operation, int result)
+	{
+		using Step = Operation::Step;
+		auto &op = *operation;
+
+		switch (op.step)
+		{
+			case Step::Open:
+				if (result < 0)
+				{
+					op.Fail(result);
+					op.step = Step::Done;
+					break;
+				}
+				op.descriptor = result;
+				op.step       = op.writing ? Step::Write : Step::Read;
+
+				if (not op.writing)
+				{
+					// The inode was just looked up by the open, stating it does not block
+					struct stat status{};
+					if (::fstat(op.descriptor, &status) < 0)
+					{
+						op.Fail(-errno);
+						op.step = Step::Close;
+						break;
+					}
+					op.data.resize(static_cast<size_t>(status.st_size));
+				}
+
+				if (op.data.empty())
+				{
+					op.step = op.sync ? Step::Sync : Step::Close;
+				}
+				break;
+			case Step::Read:
+			case Step::Write:
+				if (result <= 0)
+				{
+					if (result < 0)
+					{
+						op.Fail(result);
+					}
+					else if (op.writing)
+					{
+						// A write of nothing would be retried forever
+						op.Fail(-EIO);
+					}
+					else
+					{
+						// The file shrunk since it was opened
+						op.data.resize(op.offset);
+					}
+					op.step = Step::Close;
+					break;
+				}
+				op.offset += static_cast<size_t>(result);
+				if (op.offset == op.data.size())
+				{
+					op.step = op.sync and not op.error ? Step::Sync : Step::Close;
+				}
+				break;
+			case Step::Sync:
+				if (result < 0)
+				{
+					op.Fail(result);
+				}
+				op.step = Step::Close;
+				break;
+			case Step::Close:
+				op.descriptor = -1;
+				if (result < 0 and op.writing)
+				{
+					// Delayed write errors may only show up here
+					op.Fail(result);
+				}
+
+				if (op.error)
+				{
+					op.step = op.writing and not op.output.empty() ? Step::Discard : Step::Done;
+				}
+				else if (not op.output.empty())
+				{
+					op.step = Step::Rename;
+				}
+				else
+				{
+					op.step = op.remove.empty() ? Step::Done : Step::Unlink;
+				}
+				break;
+			case Step::Rename:
+				if (result < 0)
+				{
+					op.Fail(result);
+					op.step = Step::Discard;
+					break;
+				}
+				op.step = op.remove.empty() ? Step::Done : Step::Unlink;
+				break;
+			case Step::Unlink:
+				if (result < 0)
+				{
+					op.Fail(result);
+				}
+				op.step = Step::Done;
+				break;
+			case Step::Discard:
+			case Step::Done:
+				op.step = Step::Done;
+				break;
+		}
+
+		Start(operation);
+	}
+
+	void AsyncIo::Finish(Operation *operation)
+	{
+		unique_ptr<Operation> owned(operation);
+
+		try
+		{
+			if (owned->writing)
+			{
+				owned->onWrite(owned->error);
+			}
+			else
+			{
+				owned->onRead(owned->error, std::move(owned->data));
+			}
+		}
+		catch (exception &e)
+		{
+			cerr << "I/O callback failed: " << e.what() << endl;
+		}
+		catch (...)
+		{
+			cerr << "I/O callback failed with an unknown error" << endl;
+		}
+
+		// The buffer is freed before a waiting submitter may add another
+		owned.reset();
+
+		lock_guard l(m_mutex);
+		--m_inFlight;
+		m_completed.notify_all();
+	}
+#else
+	struct AsyncIo::Ring
+	{
+	};
+
+	struct AsyncIo::Operation
+	{
+	};
+
+	unique_ptr<AsyncIo> AsyncIo::Create(unsigned)
+	{
+		return nullptr;
+	}
+
+	AsyncIo::~AsyncIo() = default;
+
+	void AsyncIo::Read(const Path &, ReadCallback)
+	{
+		throw logic_error("Built without io_uring");
+	}
+
+	void AsyncIo::Write(WriteRequest, WriteCallback)
+	{
+		throw logic_error("Built without io_uring");
+	}
+
+	void AsyncIo::Wait()
+	{}
+#endif
+}
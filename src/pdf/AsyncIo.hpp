@@ -0,0 +1,116 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "Common.hpp"
+
+namespace PDF
+{
+	/**
+	 * Whole-file reads and writes completed in the background through a
+	 * Linux io_uring. Every file is a short chain of steps (open, read or
+	 * write, fsync, close, rename, unlink), each queued as soon as the
+	 * previous one completes, so the steps of all files in flight share
+	 * one io_uring_enter call. Callbacks run on the completion thread and
+	 * must neither throw nor submit more work.
+	 *
+	 * Only built with PDFCLEANER_IO_URING, Create() returns nullptr without
+	 * it or when the kernel refuses the ring, callers then keep their
+	 * blocking I/O.
+	 */
+	class AsyncIo
+	{
+	public:
+		using Path = boost::filesystem::path;
+
+		using ReadCallback = std::function<void(std::error_code, std::string)>;
+
+		using WriteCallback = std::function<void(std::error_code)>;
+
+		struct WriteRequest
+		{
+			Path output;
+
+			std::string contents;
+
+			/// Written first and renamed over output, empty to write output directly
+			Path temporary;
+
+			/// Flushes the data to disk before the file is renamed and remove unlinked
+			bool sync{};
+
+			/// Unlinked once output is complete, empty to keep every file
+			Path remove;
+		};
+
+		/// Files in flight at once, submitting more waits for one to complete
+		static constexpr unsigned DefaultDepth = 64;
+
+		static std::unique_ptr<AsyncIo> Create(unsigned depth = DefaultDepth);
+
+		AsyncIo(const AsyncIo &) = delete;
+
+		AsyncIo &operator=(const AsyncIo &) = delete;
+
+		/// Completes the files in flight first
+		~AsyncIo();
+
+		void Read(const Path &path, ReadCallback callback);
+
+		void Write(WriteRequest request, WriteCallback callback);
+
+		/// Blocks until every submitted file has completed
+		void Wait();
+
+	private:
+		struct Ring;
+
+		struct Operation;
+
+		AsyncIo(std::unique_ptr<Ring> ring, unsigned depth);
+
+		void Submit(std::unique_ptr<Operation> operation);
+
+		void Run();
+
+		void Start(Operation *operation);
+
+		void Advance(Operation *operation, int result);
+
+		void Finish(Operation *operation);
+
+	private:
+		std::unique_ptr<Ring> m_ring;
+
+		unsigned m_depth;
+
+		unsigned m_inFlight;
+
+		bool m_stopped;
+
+		std::mutex m_mutex;
+
+		std::condition_variable m_completed;
+
+		// Submitted files the completion thread has not taken yet
+		std::vector<std::unique_ptr<Operation>> m_pending;
+
+		std::thread m_thread;
+	};
+}
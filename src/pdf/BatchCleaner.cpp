@@ -0,0 +1,508 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <future>
+#include <mutex>
+#include <boost/filesystem/fstream.hpp>
+
+#include "AllocationStats.hpp"
+#include "AsyncIo.hpp"
+#include "BatchCleaner.hpp"
+#include "MemoryBudget.hpp"
+#include "Pipeline.hpp"
+#include "Prefilter.hpp"
+#include "ScanCache.hpp"
+#include "Trace.hpp"
+
+using namespace std;
+
+namespace bfs = boost::filesystem;
+
+namespace PDF
+{
+	static std::mutex g_outputMutex;
+
+	/// Discovered files waiting for a worker, bounds memory on huge trees
+	static constexpr size_t g_pendingFiles{4096};
+
+	/// State shared by every file of one run
+	struct BatchContext
+	{
+		unique_ptr<ScanCache> cache;
+
+		unique_ptr<Prefilter> prefilter;
+
+		unique_ptr<MemoryBudget> budget;
+
+		/// Set with --io-uring when the kernel supports it, files are then read and written in the background
+		unique_ptr<AsyncIo> io;
+
+		/// Where the name of every parsed file is printed
+		ostream *listing{};
+	};
+
+	/// One file on its way through the read, parse, clean and write stages
+	struct FileJob
+	{
+		// Declared first, the memory is given back once the document is gone
+		MemoryBudget::Reservation reservation;
+
+		FileHandler::Path path;
+
+		string outputName;
+
+		DocumentProperty properties;
+
+		string contents;
+
+		/// Contents still being read by the io_uring backend
+		future<string> reading;
+
+		/// Describes the bytes that were read, for the cache entry of the file
+		ScanCache::Source source;
+
+		unique_ptr<Inspector> inspector;
+
+		AllocationStats::Counters allocations;
+	};
+
+	/// Jobs waiting between two stages
+	static constexpr size_t g_pendingJobs{16};
+
+	/// Skips files needing no work and prefetches the others into memory
+	static bool readFile(const FileHandler &handler, const BatchContext &context, FileJob &job)
+	{
+		auto cache = context.cache.get();
+
+		job.outputName = (handler.HasPrefix()
+		                  ? handler.RemovePrefix(job.path).generic_string()
+		                  : job.path.generic_string());
+
+		if (cache and cache->IsUpToDate(job.path, job.outputName, job.source))
+		{
+			return false;
+		}
+
+		// Estimating and prefiltering look at the raw bytes before anything is copied
+		MappedFile mapping{};
+		if (context.prefilter or context.budget)
+		{
+			mapping = MappedFile(job.path);
+		}
+
+		if (context.prefilter and mapping.IsOpen() and not context.prefilter->IsCandidate(mapping.View()))
+		{
+			if (cache)
+			{
+				job.source.contentHash = ScanCache::HashBytes(mapping.View());
+				cache->Record(job.path, job.source, ScanCache::Outcome::NoMatch, {});
+			}
+			return false;
+		}
+
+		if (context.budget)
+		{
+			boost::system::error_code error{};
+			auto                      size = mapping.IsOpen() ? mapping.View().size()
+			                                                  : boost::filesystem::file_size(job.path, error);
+			auto                      need = MemoryBudget::Estimate(error ? 0 : size, MemoryBudget::CountPages(mapping.View()));
+
+			job.reservation = context.budget->Acquire(need);
+		}
+
+		// A mapped document is paged in by the kernel while it is parsed
+		if (not handler.GetOptions().mapped)
+		{
+			if (context.io and not mapping.IsOpen())
+			{
+				// The parse stage waits for the contents, this one goes on to the next file
+				auto promise = make_shared<std::promise<string>>();
+				// Ends on the completion thread once the read is done
+				auto span    = make_shared<TraceSpan>("Read", job.path.native());
+				job.reading = promise->get_future();
+
+				context.io->Read(job.path, [promise, span](error_code error, string contents)
+				{
+					if (error)
+					{
+						promise->set_exception(make_exception_ptr(system_error(error, "read")));
+						return;
+					}
+					span->SetBytes(static_cast<int64_t>(contents.size()));
+					promise->set_value(std::move(contents));
+				});
+			}
+			else
+			{
+				TraceSpan span("Read", job.path.native());
+
+				if (mapping.IsOpen())
+				{
+					job.contents.assign(mapping.View());
+				}
+				else
+				{
+					boost::filesystem::ifstream stream(job.path, ios::binary);
+					job.contents.assign(istreambuf_iterator<char>(stream), istreambuf_iterator<char>());
+				}
+				span.SetBytes(static_cast<int64_t>(job.contents.size()));
+
+				if (cache)
+				{
+					job.source.contentHash = ScanCache::HashBytes(job.contents);
+				}
+			}
+		}
+		else if (cache)
+		{
+			job.source.contentHash = mapping.IsOpen() ? ScanCache::HashBytes(mapping.View())
+			                                          : ScanCache::HashFile(job.path);
+		}
+
+		job.properties = DocumentProperty::FromFileName(job.path, handler.GetOptions().prefix);
+		return true;
+	}
+
+	static bool parseFile(const FileHandler &handler, const BatchContext &context, FileJob &job)
+	{
+		if (job.reading.valid())
+		{
+			job.contents = job.reading.get();
+
+			// Hashed here rather than on the completion thread
+			if (context.cache)
+			{
+				job.source.contentHash = ScanCache::HashBytes(job.contents);
+			}
+		}
+
+		// Empty contents make the inspector open the path itself
+		job.inspector = make_unique<Inspector>(job.path, std::move(job.contents), handler.GetPatterns(),
+		                                       BatchCleaner::CreateInspectorOptions(handler));
+		{
+			std::lock_guard l(g_outputMutex);
+			*context.listing << job.outputName << endl;
+		}
+
+		return true;
+	}
+
+	static bool cleanFile(const FileHandler &handler, const BatchContext &context, FileJob &job)
+	{
+		job.inspector->DeleteAll(handler.GetOptions().pages);
+
+		if (job.inspector->Done())
+		{
+			job.inspector->SetDocumentProperties(job.properties);
+			return true;
+		}
+
+		if (context.cache)
+		{
+			auto outcome = job.inspector->Load() ? ScanCache::Outcome::NoMatch : ScanCache::Outcome::Error;
+			context.cache->Record(job.path, job.source, outcome, job.inspector->GetKeywords());
+		}
+
+		return false;
+	}
+
+	/// Serializes the document and leaves writing, renaming and unlinking to the io_uring backend
+	static void writeFileAsync(const FileHandler &handler, const BatchContext &context, FileJob &job)
+	{
+		AsyncIo::WriteRequest     request{};
+		boost::system::error_code error{};
+		bool                      inPlace = bfs::equivalent(job.path, job.outputName, error);
+
+		request.output   = job.outputName;
+		request.contents = job.inspector->WriteToBuffer();
+
+		// The source is never truncated, a failed write leaves it as it was
+		if (inPlace)
+		{
+			request.temporary = job.outputName + ".tmp";
+		}
+
+		// The cleaned copy is on disk before the original goes
+		if (handler.HasPrefix() and handler.GetOptions().replace and not inPlace)
+		{
+			request.remove = job.path;
+			request.sync   = true;
+		}
+
+		// Described here, the completion thread only updates the cache
+		auto              cache = context.cache.get();
+		ScanCache::Source source{};
+		bool              forget{};
+
+		if (cache and not request.remove.empty())
+		{
+			forget = true;
+		}
+		else if (cache and inPlace)
+		{
+			// The input becomes the output, its time is only known once written
+			source.size        = request.contents.size();
+			source.contentHash = ScanCache::HashBytes(request.contents);
+		}
+		else if (cache)
+		{
+			source = job.source;
+		}
+
+		auto path        = job.path;
+		auto keywords    = job.inspector->GetKeywords();
+		// The buffer counts against the memory budget until it is written
+		auto reservation = make_shared<MemoryBudget::Reservation>(std::move(job.reservation));
+
+		context.io->Write(std::move(request), [cache, path, source, forget, keywords, reservation](error_code error)
+		{
+			if (cache and error)
+			{
+				cache->Record(path, source, ScanCache::Outcome::Error, {});
+			}
+			else if (cache and forget)
+			{
+				cache->Forget(path);
+			}
+			else if (cache)
+			{
+				cache->Record(path, source, ScanCache::Outcome::Cleaned, keywords);
+			}
+
+			if (error)
+			{
+				std::lock_guard l(g_outputMutex);
+				cerr << path.generic_string() << ": " << error.message() << endl;
+			}
+		});
+	}
+
+	static bool writeFile(const FileHandler &handler, const BatchContext &context, FileJob &job)
+	{
+		// PoDoFo appends incremental updates to the file itself
+		if (context.io and not handler.GetOptions().incremental)
+		{
+			writeFileAsync(handler, context, job);
+			return true;
+		}
+
+		boost::system::error_code error{};
+		bool                      inPlace = bfs::equivalent(job.path, job.outputName, error);
+		bool                      removed = handler.HasPrefix() and handler.GetOptions().replace;
+
+		job.inspector->Write(job.outputName);
+
+		if (removed)
+		{
+			boost::filesystem::remove(job.path);
+		}
+
+		if (context.cache and removed)
+		{
+			// Replaced inputs are gone, there is nothing left to skip
+			context.cache->Forget(job.path);
+		}
+		else if (context.cache and inPlace)
+		{
+			// The bytes read were overwritten, the entry describes the output
+			ScanCache::Source source{};
+
+			if (ScanCache::Describe(job.path, source))
+			{
+				context.cache->Record(job.path, source, ScanCache::Outcome::Cleaned, job.inspector->GetKeywords());
+			}
+		}
+		else if (context.cache)
+		{
+			context.cache->Record(job.path, job.source, ScanCache::Outcome::Cleaned, job.inspector->GetKeywords());
+		}
+
+		return true;
+	}
+
+	/// Options changing what is cleaned or written, a cache entry from other settings is stale
+	static string cacheSettings(const FileHandler &handler)
+	{
+		const auto &options = handler.GetOptions();
+		string     settings{};
+
+		settings.append("pages=").append(options.pages.ToString())
+		        .append(";prefix=").append(1, options.prefix)
+		        .append(";incremental=").append(to_string(options.incremental))
+		        .append(";xref-stream=").append(to_string(options.xrefStream))
+		        .append(";flate-level=").append(to_string(options.flateLevel))
+		        .append(";keep-contents=").append(to_string(options.keepContents));
+		return settings;
+	}
+
+	/**
+	 * Adds what stage allocates to the counts of the file. A parsed file
+	 * leaving the pipeline is freed inside the count and its totals printed.
+	 */
+	template<typename Stage>
+	static bool countAllocations(FileJob &job, bool last, Stage stage)
+	{
+		if (not AllocationStats::IsEnabled())
+		{
+			return stage();
+		}
+
+		bool keep;
+		bool finished;
+		{
+			AllocationScope scope(job.allocations);
+			keep     = stage();
+			finished = job.inspector and (last or not keep);
+
+			if (finished)
+			{
+				job.inspector.reset();
+			}
+		}
+
+		if (finished)
+		{
+			std::lock_guard l(g_outputMutex);
+			cerr << job.path.generic_string() << ": " << job.allocations.allocations << " allocations, "
+			     << job.allocations.bytes << " bytes, " << job.allocations.frees << " frees" << endl;
+		}
+
+		return keep;
+	}
+
+	BatchCleaner::BatchCleaner(const FileHandler &handler, ostream &listing)
+			: m_handler(handler),
+			  m_listing(listing)
+	{}
+
+	void BatchCleaner::Run()
+	{
+		const auto              &options = m_handler.GetOptions();
+		auto                    walker   = m_handler.CreateWalker();
+		DirectoryWalker::Queue  queue(g_pendingFiles);
+		BatchContext            context{};
+		Pipeline<FileJob>       pipeline(g_pendingJobs);
+
+		context.listing = &m_listing;
+
+		if (not options.traceFile.empty())
+		{
+			Trace::Enable();
+		}
+
+		if (not options.cacheFile.empty())
+		{
+			context.cache = make_unique<ScanCache>(options.cacheFile, *m_handler.GetPatterns(), cacheSettings(m_handler));
+			context.cache->Load();
+		}
+
+		if (options.prefilter)
+		{
+			context.prefilter = make_unique<Prefilter>(*m_handler.GetPatterns());
+
+			if (not context.prefilter->IsEnabled())
+			{
+				cerr << "Prefilter disabled: some pattern has no required literal" << endl;
+			}
+		}
+
+		if (options.allocStats)
+		{
+			AllocationStats::Enable();
+		}
+
+		if (options.ioUring)
+		{
+			context.io = AsyncIo::Create();
+
+			if (not context.io)
+			{
+				cerr << "io_uring unavailable, using blocking file I/O" << endl;
+			}
+		}
+
+		pipeline.AddStage("read", options.readJobs, [&](FileJob &job)
+		        {
+			        return countAllocations(job, false, [&] { return readFile(m_handler, context, job); });
+		        })
+		        .AddStage("parse", options.parseJobs, [&](FileJob &job)
+		        {
+			        return countAllocations(job, false, [&] { return parseFile(m_handler, context, job); });
+		        })
+		        .AddStage("clean", options.jobs, [&](FileJob &job)
+		        {
+			        return countAllocations(job, false, [&] { return cleanFile(m_handler, context, job); });
+		        })
+		        .AddStage("write", options.writeJobs, [&](FileJob &job)
+		        {
+			        return countAllocations(job, true, [&] { return writeFile(m_handler, context, job); });
+		        })
+		        .OnError([&context](FileJob &job, exception_ptr error)
+		        {
+			        if (context.cache)
+			        {
+				        context.cache->Record(job.path, job.source, ScanCache::Outcome::Error, {});
+			        }
+
+			        std::lock_guard l(g_outputMutex);
+			        try
+			        {
+				        rethrow_exception(error);
+			        }
+			        catch (std::exception &e)
+			        {
+				        cerr << job.path.generic_string() << ": " << e.what() << endl;
+			        }
+			        catch (...)
+			        {
+				        cerr << job.path.generic_string() << ": unknown error" << endl;
+			        }
+		        });
+
+		if (options.maxMemory)
+		{
+			context.budget = make_unique<MemoryBudget>(options.maxMemory);
+		}
+
+		// Files are cleaned while the walker is still listing directories
+		walker->Start(queue);
+
+		pipeline.Run([&queue](FileJob &job) { return queue.Pop(job.path); });
+		walker->Join();
+
+		// Writes still in flight record their outcome in the cache
+		if (context.io)
+		{
+			context.io->Wait();
+		}
+
+		if (context.cache)
+		{
+			context.cache->Save();
+		}
+
+		if (Trace::IsEnabled() and not Trace::Write(options.traceFile))
+		{
+			cerr << "Cannot write trace to \'" << options.traceFile << '\'' << endl;
+		}
+	}
+
+	InspectorOptions BatchCleaner::CreateInspectorOptions(const FileHandler &handler)
+	{
+		InspectorOptions inspectorOptions{};
+		inspectorOptions.incremental     = handler.GetOptions().incremental;
+		inspectorOptions.mapped          = handler.GetOptions().mapped;
+		inspectorOptions.pageJobs        = handler.GetOptions().pageJobs;
+		inspectorOptions.xrefStream      = handler.GetOptions().xrefStream;
+		inspectorOptions.flateLevel      = handler.GetOptions().flateLevel;
+		inspectorOptions.encodeJobs      = handler.GetOptions().encodeJobs;
+		inspectorOptions.rewriteContents = not handler.GetOptions().keepContents;
+		inspectorOptions.arena           = handler.GetOptions().arena;
+		return inspectorOptions;
+	}
+}
@@ -0,0 +1,42 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <iostream>
+
+#include "Common.hpp"
+#include "FileHandler.hpp"
+#include "Inspector.hpp"
+
+namespace PDF
+{
+	/**
+	 * One pdfsanitizer run over the inputs of a parsed handler. Files are
+	 * walked, then read, parsed, cleaned and written by the stages of a
+	 * Pipeline with the job counts, cache, prefilter, memory budget and
+	 * io_uring settings of its options.
+	 */
+	class BatchCleaner
+	{
+	public:
+		/// The name of every parsed file is printed to listing
+		explicit BatchCleaner(const FileHandler &handler, std::ostream &listing = std::cout);
+
+		/// Returns once every file is written and the cache and trace are saved
+		void Run();
+
+		NODISCARD
+		static InspectorOptions CreateInspectorOptions(const FileHandler &handler);
+
+	private:
+		const FileHandler &m_handler;
+
+		std::ostream &m_listing;
+	};
+}
@@ -0,0 +1,103 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "Common.hpp"
+
+namespace PDF
+{
+	/**
+	 * Fixed-capacity FIFO handing items from producers to consumers.
+	 * Push blocks while the queue is full, Pop while it is empty and open.
+	 * After Close, Push fails and Pop drains what is left, then fails.
+	 */
+	template<typename T>
+	class BoundedQueue
+	{
+	public:
+		explicit BoundedQueue(size_t capacity)
+				: m_closed(false),
+				  m_capacity(capacity ? capacity : 1),
+				  m_items()
+		{}
+
+		BoundedQueue(const BoundedQueue &) = delete;
+
+		BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+		bool Push(T item)
+		{
+			{
+				std::unique_lock l(m_mutex);
+				m_notFull.wait(l, [this] { return m_closed or m_items.size() < m_capacity; });
+
+				if (m_closed)
+				{
+					return false;
+				}
+
+				m_items.push_back(std::move(item));
+			}
+			m_notEmpty.notify_one();
+			return true;
+		}
+
+		NODISCARD
+		bool Pop(T &item)
+		{
+			{
+				std::unique_lock l(m_mutex);
+				m_notEmpty.wait(l, [this] { return m_closed or not m_items.empty(); });
+
+				if (m_items.empty())
+				{
+					return false;
+				}
+
+				item = std::move(m_items.front());
+				m_items.pop_front();
+			}
+			m_notFull.notify_one();
+			return true;
+		}
+
+		void Close()
+		{
+			{
+				std::lock_guard l(m_mutex);
+				m_closed = true;
+			}
+			m_notEmpty.notify_all();
+			m_notFull.notify_all();
+		}
+
+		NODISCARD
+		size_t GetCapacity() const noexcept
+		{
+			return m_capacity;
+		}
+
+	private:
+		bool m_closed;
+
+		size_t m_capacity;
+
+		std::mutex m_mutex;
+
+		std::condition_variable m_notEmpty;
+
+		std::condition_variable m_notFull;
+
+		std::deque<T> m_items;
+	};
+}
@@ -0,0 +1,462 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <algorithm>
+#include <podofo/podofo.h>
+
+#include "ContentFilter.hpp"
+#include "Flate.hpp"
+
+using namespace std;
+using namespace PoDoFo;
+
+namespace PDF
+{
+	/// Decoded bytes handed to the filter, and filtered bytes handed to the sink, at a time
+	static constexpr size_t g_chunkSize = 64 * 1024;
+
+	/// Enough to tell the operators the filter looks for from all others
+	static constexpr size_t g_operatorLength = 2;
+
+	static bool isWhitespace(char c)
+	{
+		return c == ' ' or c == '\n' or c == '\r' or c == '\t' or c == '\f' or c == '\0';
+	}
+
+	static bool isDelimiter(char c)
+	{
+		switch (c)
+		{
+			case '(':
+			case ')':
+			case '<':
+			case '>':
+			case '[':
+			case ']':
+			case '{':
+			case '}':
+			case '/':
+			case '%':
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	static bool isOperand(string_view token)
+	{
+		char first = token.empty() ? '\0' : token.front();
+		return (first >= '0' and first <= '9') or first == '+' or first == '-' or first == '.'
+		       or token == "true" or token == "false" or token == "null";
+	}
+
+	ContentFilter::ContentFilter(const set<string> &names, Sink sink)
+			: m_names(names),
+			  m_sink(std::move(sink)),
+			  m_maxNameLength(),
+			  m_removed(),
+			  m_lexeme(Lexeme::Space),
+			  m_operands(Operands::None),
+			  m_holding(false),
+			  m_depth(),
+			  m_escaped(false),
+			  m_endMarker(),
+			  m_token(),
+			  m_tokenLength(),
+			  m_name(),
+			  m_pending(),
+			  m_output()
+	{
+		for (const auto &name : m_names)
+		{
+			m_maxNameLength = max(m_maxNameLength, name.size());
+		}
+	}
+
+	void ContentFilter::Write(string_view data)
+	{
+		for (char c : data)
+		{
+			Feed(c);
+		}
+		Flush(false);
+	}
+
+	void ContentFilter::Finish()
+	{
+		if (m_lexeme == Lexeme::Name)
+		{
+			EndName();
+		}
+		else if (m_lexeme == Lexeme::Regular)
+		{
+			EndRegular();
+		}
+
+		// An operation cut off by the end of the content is kept as it is
+		if (m_holding)
+		{
+			m_output += m_pending;
+			m_pending.clear();
+			m_holding = false;
+		}
+		Flush(true);
+	}
+
+	size_t ContentFilter::GetRemovedCount() const noexcept
+	{
+		return m_removed;
+	}
+
+	void ContentFilter::Feed(char c)
+	{
+		// A character ending a token is read again in the state that follows it
+		for (;;)
+		{
+			switch (m_lexeme)
+			{
+				case Lexeme::Space:
+					if (isWhitespace(c))
+					{
+						Emit(c);
+						return;
+					}
+
+					switch (c)
+					{
+						case '%':
+							m_lexeme = Lexeme::Comment;
+							break;
+						case '/':
+							// Only a name opening the operation may be dropped with it
+							if (m_operands == Operands::None)
+							{
+								m_holding = true;
+							}
+							else
+							{
+								StartOperand();
+							}
+							m_name.clear();
+							m_lexeme = Lexeme::Name;
+							break;
+						case '(':
+							StartOperand();
+							m_depth   = 1;
+							m_escaped = false;
+							m_lexeme  = Lexeme::Literal;
+							break;
+						case '<':
+							StartOperand();
+							m_lexeme = Lexeme::Less;
+							break;
+						case '>':
+							StartOperand();
+							m_lexeme = Lexeme::Greater;
+							break;
+						case ')':
+						case '[':
+						case ']':
+						case '{':
+						case '}':
+							StartOperand();
+							break;
+						default:
+							m_token.clear();
+							m_tokenLength = 0;
+							m_lexeme      = Lexeme::Regular;
+							continue;
+					}
+					Emit(c);
+					return;
+
+				case Lexeme::Comment:
+					Emit(c);
+					if (c == '\r' or c == '\n')
+					{
+						m_lexeme = Lexeme::Space;
+					}
+					return;
+
+				case Lexeme::Name:
+					if (isWhitespace(c) or isDelimiter(c))
+					{
+						EndName();
+						m_lexeme = Lexeme::Space;
+						continue;
+					}
+					if (m_name.size() <= m_maxNameLength)
+					{
+						m_name.push_back(c);
+					}
+					Emit(c);
+					return;
+
+				case Lexeme::Regular:
+					if (isWhitespace(c) or isDelimiter(c))
+					{
+						EndRegular();
+						continue;
+					}
+					if (m_token.size() <= g_operatorLength)
+					{
+						m_token.push_back(c);
+					}
+					++m_tokenLength;
+					Emit(c);
+					return;
+
+				case Lexeme::Literal:
+					Emit(c);
+					if (m_escaped)
+					{
+						m_escaped = false;
+					}
+					else if (c == '\\')
+					{
+						m_escaped = true;
+					}
+					else if (c == '(')
+					{
+						++m_depth;
+					}
+					else if (c == ')' and --m_depth == 0)
+					{
+						m_lexeme = Lexeme::Space;
+					}
+					return;
+
+				case Lexeme::Less:
+					if (c == '<')
+					{
+						Emit(c);
+						m_lexeme = Lexeme::Space;
+						return;
+					}
+					m_lexeme = Lexeme::Hex;
+					continue;
+
+				case Lexeme::Hex:
+					Emit(c);
+					if (c == '>')
+					{
+						m_lexeme = Lexeme::Space;
+					}
+					return;
+
+				case Lexeme::Greater:
+					m_lexeme = Lexeme::Space;
+					if (c == '>')
+					{
+						Emit(c);
+						return;
+					}
+					continue;
+
+				case Lexeme::InlineData:
+					// Image data ends at EI preceded by white space and followed by white space or a delimiter
+					if (m_endMarker == 3)
+					{
+						if (isWhitespace(c) or isDelimiter(c))
+						{
+							m_lexeme = Lexeme::Space;
+							continue;
+						}
+						m_endMarker = 0;
+					}
+
+					Emit(c);
+					if (isWhitespace(c))
+					{
+						m_endMarker = 1;
+					}
+					else if ((m_endMarker == 1 and c == 'E') or (m_endMarker == 2 and c == 'I'))
+					{
+						++m_endMarker;
+					}
+					else
+					{
+						m_endMarker = 0;
+					}
+					return;
+			}
+		}
+	}
+
+	void ContentFilter::Emit(char c)
+	{
+		(m_holding ? m_pending : m_output).push_back(c);
+	}
+
+	void ContentFilter::StartOperand()
+	{
+		if (m_holding)
+		{
+			m_output += m_pending;
+			m_pending.clear();
+			m_holding = false;
+		}
+		m_operands = Operands::Other;
+	}
+
+	void ContentFilter::EndName()
+	{
+		if (not m_holding or m_operands != Operands::None)
+		{
+			return;
+		}
+
+		// A name that cannot be dropped is let through right away
+		if (m_name.size() <= m_maxNameLength and m_names.count(m_name))
+		{
+			m_operands = Operands::OneName;
+		}
+		else
+		{
+			StartOperand();
+		}
+	}
+
+	void ContentFilter::EndRegular()
+	{
+		m_lexeme = Lexeme::Space;
+
+		if (isOperand(m_token))
+		{
+			StartOperand();
+			return;
+		}
+
+		bool known = m_tokenLength == g_operatorLength;
+		bool drop  = known and m_holding and m_operands == Operands::OneName
+		             and (m_token == "Do" or m_token == "sh" or m_token == "gs");
+
+		if (drop)
+		{
+			++m_removed;
+		}
+		else
+		{
+			m_output += m_pending;
+		}
+
+		m_pending.clear();
+		m_holding  = false;
+		m_operands = Operands::None;
+
+		if (known and m_token == "ID")
+		{
+			m_lexeme    = Lexeme::InlineData;
+			m_endMarker = 0;
+		}
+	}
+
+	void ContentFilter::Flush(bool force)
+	{
+		if (not m_output.empty() and (force or m_output.size() >= g_chunkSize))
+		{
+			m_sink(m_output);
+			m_output.clear();
+		}
+	}
+
+	ContentRewriter::ContentRewriter(const set<string> &names, int level)
+			: m_names(names),
+			  m_level(level)
+	{}
+
+	bool ContentRewriter::Rewrite(PdfObject *object)
+	{
+		if (m_names.empty() or not object or not object->HasStream())
+		{
+			return false;
+		}
+
+		auto &dictionary = object->GetDictionary();
+		auto filter      = object->GetIndirectKey(PdfName::KeyFilter);
+		bool plain       = not filter;
+		bool flate       = false;
+
+		if (filter and not dictionary.HasKey("DecodeParms"))
+		{
+			if (filter->IsArray() and filter->GetArray().size() == 1)
+			{
+				filter = &filter->GetArray().front();
+			}
+			flate = filter->IsName() and filter->GetName() == PdfName("FlateDecode");
+		}
+
+		char     *data{};
+		pdf_long length{};
+
+		try
+		{
+			// Plain and Flate data are decoded here chunk by chunk, anything else by PoDoFo at once
+			if (plain or flate)
+			{
+				object->GetStream()->GetCopy(&data, &length);
+			}
+			else
+			{
+				object->GetStream()->GetFilteredCopy(&data, &length);
+			}
+		}
+		catch (PdfError &)
+		{
+			return false;
+		}
+
+		unique_ptr<char, void (*)(void *)> holder(data, podofo_free);
+		string_view                        input(data, static_cast<size_t>(length));
+
+		auto run = [&input, flate](ContentFilter &contentFilter)
+		{
+			if (flate)
+			{
+				Flate::Inflate(input, g_chunkSize, [&contentFilter](string_view chunk) { contentFilter.Write(chunk); });
+			}
+			else
+			{
+				for (size_t offset{}; offset < input.size(); offset += g_chunkSize)
+				{
+					contentFilter.Write(input.substr(offset, g_chunkSize));
+				}
+			}
+			contentFilter.Finish();
+		};
+
+		try
+		{
+			// Most streams hold nothing to drop, a first pass without encoding finds out cheaply
+			ContentFilter probe(m_names, [](string_view) {});
+			run(probe);
+
+			if (not probe.GetRemovedCount())
+			{
+				return false;
+			}
+
+			Deflater      deflater(m_level);
+			ContentFilter contentFilter(m_names, [&deflater](string_view chunk) { deflater.Write(chunk); });
+			run(contentFilter);
+
+			auto           encoded = deflater.Finish();
+			PdfInputDevice device(encoded.data(), encoded.size());
+			object->GetStream()->SetRawData(&device, static_cast<pdf_long>(encoded.size()));
+		}
+		catch (std::exception &)
+		{
+			// A corrupt stream is left as it was
+			return false;
+		}
+
+		dictionary.AddKey(PdfName::KeyFilter, PdfName("FlateDecode"));
+		dictionary.RemoveKey("DecodeParms");
+		return true;
+	}
+}
@@ -0,0 +1,131 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <functional>
+#include <set>
+#include <string>
+#include <string_view>
+
+#include "Common.hpp"
+
+namespace PoDoFo
+{
+	class PdfObject;
+}
+
+namespace PDF
+{
+	/**
+	 * Streaming lexer over decoded content stream bytes that drops
+	 * "/Name Do", "/Name sh" and "/Name gs" for the given names and
+	 * passes everything else through unchanged. Input may be split
+	 * anywhere, only the operation being read is held back, and only
+	 * while it can still turn out to be one of those three.
+	 */
+	class ContentFilter
+	{
+	public:
+		using Sink = std::function<void(std::string_view)>;
+
+		ContentFilter(const std::set<std::string> &names, Sink sink);
+
+		void Write(std::string_view data);
+
+		/// Flushes what is held back, the content must end here
+		void Finish();
+
+		/// Operations dropped so far
+		NODISCARD
+		size_t GetRemovedCount() const noexcept;
+
+	private:
+		enum class Lexeme
+		{
+			Space,
+			Comment,
+			Name,
+			Regular,
+			Literal,
+			Hex,
+			Less,
+			Greater,
+			InlineData
+		};
+
+		enum class Operands
+		{
+			None,
+			OneName,
+			Other
+		};
+
+		void Feed(char c);
+
+		void Emit(char c);
+
+		void StartOperand();
+
+		void EndName();
+
+		void EndRegular();
+
+		void Flush(bool force);
+
+	private:
+		const std::set<std::string> &m_names;
+
+		Sink m_sink;
+
+		size_t m_maxNameLength;
+
+		size_t m_removed;
+
+		Lexeme m_lexeme;
+
+		Operands m_operands;
+
+		bool m_holding;
+
+		int m_depth;
+
+		bool m_escaped;
+
+		int m_endMarker;
+
+		std::string m_token;
+
+		size_t m_tokenLength;
+
+		std::string m_name;
+
+		std::string m_pending;
+
+		std::string m_output;
+	};
+
+	/**
+	 * Rewrites content streams through ContentFilter, decoding and
+	 * re-encoding Flate data in chunks so the decoded content is never
+	 * held whole. Other filters are decoded by PoDoFo first.
+	 */
+	class ContentRewriter
+	{
+	public:
+		ContentRewriter(const std::set<std::string> &names, int level);
+
+		/// Replaces the stream of object when an operation was dropped
+		bool Rewrite(PoDoFo::PdfObject *object);
+
+	private:
+		const std::set<std::string> &m_names;
+
+		int m_level;
+	};
+}
@@ -0,0 +1,678 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "DfaMatcher.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	/// NFA states of one text position in insertion order, membership tests take constant time
+	struct DfaMatcher::Threads
+	{
+		explicit Threads(size_t stateCount)
+				: dense(stateCount),
+				  sparse(stateCount),
+				  size(),
+				  kept(),
+				  hash()
+		{
+			kept.reserve(stateCount);
+		}
+
+		bool Contains(int index) const noexcept
+		{
+			auto slot = sparse[static_cast<size_t>(index)];
+			return slot < size and dense[slot] == index;
+		}
+
+		void Insert(int index) noexcept
+		{
+			sparse[static_cast<size_t>(index)] = static_cast<uint32_t>(size);
+			dense[size++] = index;
+		}
+
+		void Clear() noexcept
+		{
+			size = 0;
+			kept.clear();
+			hash = 0;
+		}
+
+		vector<int> dense;
+
+		// Read before it is written, stale slots fail the check against dense
+		vector<uint32_t> sparse;
+
+		size_t size;
+
+		// The Bytes, End and Match states among them and the sum of their hashes,
+		// Split and Begin states only lead to these and play no part in a DFA state
+		StateSet kept;
+
+		uint64_t hash;
+	};
+
+	/// DFA states built by one Simulate() call, only the transitions taken are ever filled in
+	struct DfaMatcher::LazyDfa
+	{
+		LazyDfa(size_t stateCount, size_t classCount)
+				: sets(),
+				  ids(),
+				  transitions(),
+				  accepting(),
+				  storedStates(),
+				  flushes(),
+				  built(),
+				  classCount(classCount),
+				  current(stateCount),
+				  next(stateCount),
+				  stack()
+		{
+			stack.reserve(stateCount);
+		}
+
+		void Flush()
+		{
+			sets.clear();
+			ids.clear();
+			transitions.clear();
+			accepting.clear();
+			storedStates = 0;
+			++flushes;
+		}
+
+		// Kept states of every cached state, in no particular order
+		vector<StateSet> sets;
+
+		// Keyed by the hash of the kept states, which ignores their order
+		unordered_multimap<uint64_t, int> ids;
+
+		// -1 for transitions not taken yet
+		vector<int32_t> transitions;
+
+		vector<uint8_t> accepting;
+
+		size_t storedStates;
+
+		size_t flushes;
+
+		// New states over the whole search, flushed ones included
+		size_t built;
+
+		size_t classCount;
+
+		// Scratch of the transition being built
+		Threads current;
+
+		Threads next;
+
+		vector<int> stack;
+	};
+
+	/// NFA states kept by the cache of one search before it is flushed
+	static constexpr size_t g_lazyCacheStates{1u << 20};
+
+	/// The cache is given up once fewer bytes than this are read per state it builds
+	static constexpr size_t g_bytesPerLazyState{4};
+
+	/// Summed over a set, equal sets hash alike whatever order they were reached in
+	static uint64_t hashState(int index) noexcept
+	{
+		// splitmix64 finalizer
+		auto hash = static_cast<uint64_t>(index) + 0x9e3779b97f4a7c15ULL;
+		hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+		return hash ^ (hash >> 31);
+	}
+
+	DfaMatcher::DfaMatcher(const RegexNode &root)
+			: m_nfa(),
+			  m_nfaStart(),
+			  m_classCount(),
+			  m_classOf(),
+			  m_transitions(),
+			  m_accepting(),
+			  m_acceptingAtEnd(),
+			  m_dead(),
+			  m_hasDfa(),
+			  m_stateHashes(),
+			  m_successors(),
+			  m_classStates(),
+			  m_stateWords()
+	{
+		int match = AddState(NfaState::Kind::Match, {});
+		m_nfaStart = Compile(root, match);
+
+		BuildClasses();
+		m_hasDfa = BuildDfa();
+
+		if (not m_hasDfa)
+		{
+			if (m_nfa.size() > MaxLazyStates)
+			{
+				throw invalid_argument("Pattern is too large to match without a DFA");
+			}
+			BuildLazyTables();
+		}
+	}
+
+	bool DfaMatcher::Search(string_view text) const
+	{
+		if (not m_hasDfa)
+		{
+			return Simulate(text);
+		}
+
+		// DFA state 0 is the start state
+		size_t state{};
+
+		if (m_accepting[state])
+		{
+			return true;
+		}
+
+		for (unsigned char byte : text)
+		{
+			state = static_cast<size_t>(m_transitions[state * m_classCount + m_classOf[byte]]);
+
+			if (m_accepting[state])
+			{
+				return true;
+			}
+			if (m_dead[state])
+			{
+				return false;
+			}
+		}
+
+		return m_acceptingAtEnd[state];
+	}
+
+	bool DfaMatcher::HasDfa() const noexcept
+	{
+		return m_hasDfa;
+	}
+
+	int DfaMatcher::AddState(NfaState::Kind kind, vector<int> next, const RegexNode::ByteSet &bytes)
+	{
+		// Trees that did not come from RegexParser::Parse() are bounded here, the match state comes on top
+		if (m_nfa.size() > RegexParser::MaxProgramSize)
+		{
+			throw invalid_argument("Pattern compiles to too many states");
+		}
+
+		m_nfa.push_back({kind, bytes, std::move(next)});
+		return static_cast<int>(m_nfa.size() - 1);
+	}
+
+	int DfaMatcher::Compile(const RegexNode &node, int next)
+	{
+		switch (node.type)
+		{
+			case RegexNode::Type::Empty:
+				return next;
+			case RegexNode::Type::Bytes:
+				return AddState(NfaState::Kind::Bytes, {next}, node.bytes);
+			case RegexNode::Type::Begin:
+				return AddState(NfaState::Kind::Begin, {next});
+			case RegexNode::Type::End:
+				return AddState(NfaState::Kind::End, {next});
+			case RegexNode::Type::Concat:
+				// Built back to front so every child knows its successor
+				for (auto child = node.children.rbegin(); child != node.children.rend(); ++child)
+				{
+					next = Compile(**child, next);
+				}
+				return next;
+			case RegexNode::Type::Alternate:
+			{
+				vector<int> branches{};
+				for (auto &child : node.children)
+				{
+					branches.push_back(Compile(*child, next));
+				}
+				return AddState(NfaState::Kind::Split, std::move(branches));
+			}
+			case RegexNode::Type::Repeat:
+			{
+				const auto &child = *node.children.front();
+
+				if (node.max == RegexNode::Unbounded)
+				{
+					int loop = AddState(NfaState::Kind::Split, {});
+					int body = Compile(child, loop);
+					m_nfa[loop].next = {body, next};
+					next = loop;
+				}
+				else
+				{
+					for (int i = node.min; i < node.max; ++i)
+					{
+						int body = Compile(child, next);
+						next = AddState(NfaState::Kind::Split, {body, next});
+					}
+				}
+
+				for (int i{}; i < node.min; ++i)
+				{
+					next = Compile(child, next);
+				}
+				return next;
+			}
+		}
+		return next;
+	}
+
+	DfaMatcher::StateSet DfaMatcher::Closure(const StateSet &seeds, bool atBegin, bool atEnd) const
+	{
+		StateSet     result{};
+		StateSet     stack(seeds);
+		vector<bool> visited(m_nfa.size());
+
+		while (not stack.empty())
+		{
+			int index = stack.back();
+			stack.pop_back();
+
+			if (visited[index])
+			{
+				continue;
+			}
+			visited[index] = true;
+
+			const auto &state = m_nfa[index];
+
+			switch (state.kind)
+			{
+				case NfaState::Kind::Bytes:
+				case NfaState::Kind::Match:
+					result.push_back(index);
+					break;
+				case NfaState::Kind::Split:
+					stack.insert(stack.end(), state.next.rbegin(), state.next.rend());
+					break;
+				case NfaState::Kind::Begin:
+					if (atBegin)
+					{
+						stack.push_back(state.next.front());
+					}
+					break;
+				case NfaState::Kind::End:
+					if (atEnd)
+					{
+						stack.push_back(state.next.front());
+					}
+					else
+					{
+						// Kept so the end of the text can still resolve it
+						result.push_back(index);
+					}
+					break;
+			}
+		}
+
+		sort(result.begin(), result.end());
+		return result;
+	}
+
+	DfaMatcher::StateSet DfaMatcher::Step(const StateSet &states, unsigned char byte) const
+	{
+		// The start state is re-entered at every position for an unanchored search
+		StateSet moved{m_nfaStart};
+
+		for (int index : states)
+		{
+			const auto &state = m_nfa[index];
+			if (state.kind == NfaState::Kind::Bytes and state.bytes.test(byte))
+			{
+				moved.push_back(state.next.front());
+			}
+		}
+
+		return Closure(moved, false, false);
+	}
+
+	bool DfaMatcher::HasMatch(const StateSet &states) const
+	{
+		return any_of(states.begin(), states.end(),
+		              [this](int index) { return m_nfa[index].kind == NfaState::Kind::Match; });
+	}
+
+	void DfaMatcher::BuildClasses()
+	{
+		// Bytes that no set tells apart share one class and one table column
+		map<vector<bool>, uint16_t> classes{};
+
+		for (unsigned byte{}; byte < m_classOf.size(); ++byte)
+		{
+			vector<bool> signature{};
+			signature.reserve(m_nfa.size());
+
+			for (const auto &state : m_nfa)
+			{
+				if (state.kind == NfaState::Kind::Bytes)
+				{
+					signature.push_back(state.bytes.test(byte));
+				}
+			}
+
+			auto [iter, inserted] = classes.emplace(std::move(signature), static_cast<uint16_t>(classes.size()));
+			m_classOf[byte] = iter->second;
+		}
+
+		m_classCount = classes.size();
+	}
+
+	bool DfaMatcher::BuildDfa()
+	{
+		vector<StateSet>    sets{};
+		map<StateSet, int>  ids{};
+		vector<uint8_t>     representative(m_classCount);
+
+		for (unsigned byte = m_classOf.size(); byte-- > 0;)
+		{
+			representative[m_classOf[byte]] = static_cast<uint8_t>(byte);
+		}
+
+		auto start = Closure({m_nfaStart}, true, false);
+		sets.push_back(start);
+		ids.emplace(start, 0);
+
+		m_accepting.push_back(HasMatch(start));
+		m_acceptingAtEnd.push_back(HasMatch(Closure({m_nfaStart}, true, true)));
+		m_dead.push_back(start.empty());
+
+		for (size_t current{}; current < sets.size(); ++current)
+		{
+			for (size_t cls{}; cls < m_classCount; ++cls)
+			{
+				// Search stops at the first accepting state, it needs no edges
+				if (m_accepting[current])
+				{
+					m_transitions.push_back(static_cast<int32_t>(current));
+					continue;
+				}
+
+				auto next = Step(sets[current], representative[cls]);
+				auto iter = ids.find(next);
+
+				if (iter == ids.end())
+				{
+					if (sets.size() >= MaxStates)
+					{
+						m_transitions.clear();
+						return false;
+					}
+
+					iter = ids.emplace(next, static_cast<int>(sets.size())).first;
+					m_accepting.push_back(HasMatch(next));
+					m_acceptingAtEnd.push_back(HasMatch(Closure(next, false, true)));
+					m_dead.push_back(next.empty());
+					sets.push_back(std::move(next));
+				}
+
+				m_transitions.push_back(iter->second);
+			}
+		}
+
+		return true;
+	}
+
+	void DfaMatcher::BuildLazyTables()
+	{
+		m_stateWords = (m_nfa.size() + 63) / 64;
+		m_stateHashes.resize(m_nfa.size());
+		m_successors.assign(m_nfa.size(), -1);
+		m_classStates.assign(m_classCount * m_stateWords, 0);
+
+		for (size_t index{}; index < m_nfa.size(); ++index)
+		{
+			const auto &state = m_nfa[index];
+
+			m_stateHashes[index] = hashState(static_cast<int>(index));
+
+			if (state.kind != NfaState::Kind::Bytes)
+			{
+				continue;
+			}
+
+			m_successors[index] = state.next.front();
+
+			for (unsigned byte{}; byte < m_classOf.size(); ++byte)
+			{
+				if (state.bytes.test(byte))
+				{
+					m_classStates[m_classOf[byte] * m_stateWords + index / 64] |= uint64_t{1} << (index % 64);
+				}
+			}
+		}
+	}
+
+	bool DfaMatcher::AddThreads(Threads &threads, vector<int> &stack, int seed, bool atBegin, bool atEnd) const
+	{
+		bool matched{};
+
+		// Most successors read a byte, they need no walk
+		if (m_successors[seed] >= 0)
+		{
+			if (not threads.Contains(seed))
+			{
+				threads.Insert(seed);
+				threads.kept.push_back(seed);
+				threads.hash += m_stateHashes[seed];
+			}
+			return false;
+		}
+
+		stack.push_back(seed);
+
+		while (not stack.empty())
+		{
+			int index = stack.back();
+			stack.pop_back();
+
+			if (threads.Contains(index))
+			{
+				continue;
+			}
+			threads.Insert(index);
+
+			const auto &state = m_nfa[index];
+
+			switch (state.kind)
+			{
+				case NfaState::Kind::Split:
+					stack.insert(stack.end(), state.next.rbegin(), state.next.rend());
+					continue;
+				case NfaState::Kind::Begin:
+					if (atBegin)
+					{
+						stack.push_back(state.next.front());
+					}
+					continue;
+				case NfaState::Kind::End:
+					// Kept either way, the end of the text resolves it
+					if (atEnd)
+					{
+						stack.push_back(state.next.front());
+					}
+					break;
+				case NfaState::Kind::Match:
+					matched = true;
+					break;
+				case NfaState::Kind::Bytes:
+					break;
+			}
+
+			threads.kept.push_back(index);
+			threads.hash += m_stateHashes[index];
+		}
+
+		return matched;
+	}
+
+	int DfaMatcher::AddLazyState(LazyDfa &dfa, const Threads &threads, bool matched) const
+	{
+		for (auto [iter, end] = dfa.ids.equal_range(threads.hash); iter != end; ++iter)
+		{
+			const auto &cached = dfa.sets[static_cast<size_t>(iter->second)];
+
+			if (cached.size() == threads.kept.size() and
+			    all_of(cached.begin(), cached.end(), [&threads](int index) { return threads.Contains(index); }))
+			{
+				return iter->second;
+			}
+		}
+
+		if (dfa.sets.size() >= MaxStates or dfa.storedStates + threads.kept.size() > g_lazyCacheStates)
+		{
+			dfa.Flush();
+		}
+
+		int id = static_cast<int>(dfa.sets.size());
+
+		++dfa.built;
+		dfa.storedStates += threads.kept.size();
+		dfa.ids.emplace(threads.hash, id);
+		dfa.sets.push_back(threads.kept);
+		dfa.transitions.resize(dfa.transitions.size() + dfa.classCount, -1);
+		dfa.accepting.push_back(matched);
+		return id;
+	}
+
+	bool DfaMatcher::Advance(const StateSet &states, unsigned char byte, Threads &into, vector<int> &stack) const
+	{
+		const uint64_t *reads = &m_classStates[m_classOf[byte] * m_stateWords];
+
+		// The start state is re-entered at every position for an unanchored search
+		into.Clear();
+		bool matched = AddThreads(into, stack, m_nfaStart, false, false);
+
+		for (int index : states)
+		{
+			if (not (reads[index >> 6] >> (index & 63) & 1))
+			{
+				continue;
+			}
+
+			// Chains of Bytes states are the common case, added here without the walk
+			int successor = m_successors[index];
+
+			if (m_successors[successor] < 0)
+			{
+				matched = AddThreads(into, stack, successor, false, false) or matched;
+			}
+			else if (not into.Contains(successor))
+			{
+				into.Insert(successor);
+				into.kept.push_back(successor);
+				into.hash += m_stateHashes[successor];
+			}
+		}
+
+		return matched;
+	}
+
+	bool DfaMatcher::MatchesAtEnd(const StateSet &states, Threads &scratch, vector<int> &stack) const
+	{
+		scratch.Clear();
+
+		for (int index : states)
+		{
+			const auto &state = m_nfa[index];
+
+			if (state.kind == NfaState::Kind::Match)
+			{
+				return true;
+			}
+			if (state.kind == NfaState::Kind::End and AddThreads(scratch, stack, state.next.front(), false, true))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool DfaMatcher::Simulate(string_view text) const
+	{
+		if (text.empty())
+		{
+			return HasMatch(Closure({m_nfaStart}, true, true));
+		}
+
+		LazyDfa dfa(m_nfa.size(), m_classCount);
+		size_t  position{};
+
+		bool matched = AddThreads(dfa.current, dfa.stack, m_nfaStart, true, false);
+		int  state   = AddLazyState(dfa, dfa.current, matched);
+
+		for (; position < text.size(); ++position)
+		{
+			if (dfa.accepting[static_cast<size_t>(state)])
+			{
+				return true;
+			}
+
+			// Nearly every byte builds a new state, the cache costs more than it saves
+			if (dfa.built > MaxStates and dfa.built * g_bytesPerLazyState > position)
+			{
+				break;
+			}
+
+			auto byte   = static_cast<unsigned char>(text[position]);
+			auto slot   = static_cast<size_t>(state) * m_classCount + m_classOf[byte];
+			int  target = dfa.transitions[slot];
+
+			if (target < 0)
+			{
+				matched = Advance(dfa.sets[static_cast<size_t>(state)], byte, dfa.next, dfa.stack);
+
+				auto flushes = dfa.flushes;
+				target = AddLazyState(dfa, dfa.next, matched);
+
+				// Unless a flush just dropped the state the transition leaves from
+				if (dfa.flushes == flushes)
+				{
+					dfa.transitions[slot] = target;
+				}
+			}
+
+			state = target;
+		}
+
+		if (position == text.size())
+		{
+			return MatchesAtEnd(dfa.sets[static_cast<size_t>(state)], dfa.current, dfa.stack);
+		}
+
+		// The rest of the text steps the NFA directly, still without allocating
+		dfa.current.Clear();
+		dfa.current.kept = dfa.sets[static_cast<size_t>(state)];
+		matched = false;
+
+		for (; position < text.size(); ++position)
+		{
+			if (matched)
+			{
+				return true;
+			}
+
+			matched = Advance(dfa.current.kept, static_cast<unsigned char>(text[position]), dfa.next, dfa.stack);
+			swap(dfa.current, dfa.next);
+		}
+
+		return matched or MatchesAtEnd(dfa.current.kept, dfa.next, dfa.stack);
+	}
+}
@@ -0,0 +1,141 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Matcher.hpp"
+#include "RegexParser.hpp"
+
+namespace PDF
+{
+	/**
+	 * Linear-time matcher. The syntax tree is compiled to a Thompson NFA
+	 * which is turned into a DFA over byte classes up front, so matching
+	 * reads every byte of the text once and never backtracks. Patterns
+	 * whose DFA would exceed MaxStates fall back to a lazy DFA: states are
+	 * built from the NFA as the text reaches them and kept in a cache that
+	 * is flushed when full, so a byte costs one table lookup once the cache
+	 * is warm. Text building a new state at nearly every byte is finished
+	 * by stepping the NFA over preallocated sets. Either way matching stays
+	 * linear in the text length.
+	 */
+	class DfaMatcher final : public Matcher
+	{
+	public:
+		static constexpr size_t MaxStates = 4096;
+
+		/**
+		 * Largest NFA matched without a full DFA, a byte of text costs up to
+		 * this many steps there. Larger patterns are rejected as they compile.
+		 */
+		static constexpr size_t MaxLazyStates = 2048;
+
+		/// Throws std::invalid_argument when the pattern is too large to match
+		explicit DfaMatcher(const RegexNode &root);
+
+		NODISCARD
+		bool Search(std::string_view text) const override;
+
+		/// False once the pattern fell back to simulating the NFA
+		NODISCARD
+		bool HasDfa() const noexcept;
+
+	private:
+		struct NfaState
+		{
+			enum class Kind
+			{
+				Bytes,
+				Split,
+				Begin,
+				End,
+				Match
+			};
+
+			Kind kind;
+
+			RegexNode::ByteSet bytes;
+
+			std::vector<int> next;
+		};
+
+		using StateSet = std::vector<int>;
+
+		struct Threads;
+
+		struct LazyDfa;
+
+		int AddState(NfaState::Kind kind, std::vector<int> next, const RegexNode::ByteSet &bytes = {});
+
+		int Compile(const RegexNode &node, int next);
+
+		NODISCARD
+		StateSet Closure(const StateSet &seeds, bool atBegin, bool atEnd) const;
+
+		NODISCARD
+		StateSet Step(const StateSet &states, unsigned char byte) const;
+
+		NODISCARD
+		bool HasMatch(const StateSet &states) const;
+
+		void BuildClasses();
+
+		bool BuildDfa();
+
+		void BuildLazyTables();
+
+		/// Adds the states reached from seed without reading a byte, true if one of them is the match
+		bool AddThreads(Threads &threads, std::vector<int> &stack, int seed, bool atBegin, bool atEnd) const;
+
+		/// Cached state of the kept states of threads, flushes the cache first when it is full
+		int AddLazyState(LazyDfa &dfa, const Threads &threads, bool matched) const;
+
+		/// Fills into with the states after reading byte from states, true if one of them is the match
+		bool Advance(const StateSet &states, unsigned char byte, Threads &into, std::vector<int> &stack) const;
+
+		NODISCARD
+		bool MatchesAtEnd(const StateSet &states, Threads &scratch, std::vector<int> &stack) const;
+
+		NODISCARD
+		bool Simulate(std::string_view text) const;
+
+	private:
+		std::vector<NfaState> m_nfa;
+
+		int m_nfaStart;
+
+		size_t m_classCount;
+
+		std::array<uint16_t, 256> m_classOf;
+
+		std::vector<int32_t> m_transitions;
+
+		std::vector<uint8_t> m_accepting;
+
+		std::vector<uint8_t> m_acceptingAtEnd;
+
+		std::vector<uint8_t> m_dead;
+
+		bool m_hasDfa;
+
+		// Only built for the lazy DFA, the NFA in the compact form read at every step
+		std::vector<uint64_t> m_stateHashes;
+
+		// Successor of every Bytes state, -1 for the other states
+		std::vector<int32_t> m_successors;
+
+		// Per byte class, a bit for every Bytes state reading it
+		std::vector<uint64_t> m_classStates;
+
+		size_t m_stateWords;
+	};
+}
@@ -0,0 +1,118 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <iostream>
+
+#include "DirectoryWalker.hpp"
+#include "Trace.hpp"
+
+using namespace std;
+namespace bfs = boost::filesystem;
+
+namespace PDF
+{
+	DirectoryWalker::DirectoryWalker(vector<Path> roots, bool recursive, size_t threadCount, Filter filter)
+			: m_roots(std::move(roots)),
+			  m_recursive(recursive),
+			  m_threadCount(threadCount),
+			  m_filter(std::move(filter)),
+			  m_pool(),
+			  m_thread()
+	{}
+
+	DirectoryWalker::~DirectoryWalker()
+	{
+		Join();
+	}
+
+	void DirectoryWalker::Start(Queue &queue)
+	{
+		m_thread = thread(&DirectoryWalker::Walk, this, std::ref(queue));
+	}
+
+	void DirectoryWalker::Join()
+	{
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+	}
+
+	void DirectoryWalker::Walk(Queue &queue)
+	{
+		m_pool = make_unique<ThreadPool>(m_threadCount);
+
+		for (const auto &root : m_roots)
+		{
+			boost::system::error_code error;
+
+			if (root.empty())
+			{
+				continue;
+			}
+			else if (bfs::is_directory(root, error))
+			{
+				m_pool->Submit([this, root, &queue] { List(root, queue); });
+			}
+			else if (error)
+			{
+				cerr << root.generic_string() << ": " << error.message() << endl;
+			}
+			else if (m_filter(root))
+			{
+				queue.Push(root);
+			}
+		}
+
+		// Tasks submitted by List() are waited for as well
+		m_pool->Wait();
+		m_pool.reset();
+		queue.Close();
+	}
+
+	void DirectoryWalker::List(const Path &directory, Queue &queue)
+	{
+		TraceSpan                 span("List directory", directory.native());
+		boost::system::error_code error;
+		bfs::directory_iterator   iter(directory, error), end;
+		int64_t                   entries{};
+
+		Trace::SetThreadName("walk");
+
+		for (; not error and iter != end; iter.increment(error), ++entries)
+		{
+			const auto &entry = *iter;
+			auto       status = entry.symlink_status(error);
+
+			if (error)
+			{
+				break;
+			}
+
+			if (bfs::is_directory(status))
+			{
+				if (m_recursive)
+				{
+					m_pool->Submit([this, path = entry.path(), &queue] { List(path, queue); });
+				}
+			}
+			else if (m_filter(entry.path()) and not queue.Push(entry.path()))
+			{
+				// Consumers closed the queue, nothing more is wanted
+				return;
+			}
+		}
+
+		span.SetCount(entries);
+
+		if (error)
+		{
+			cerr << directory.generic_string() << ": " << error.message() << endl;
+		}
+	}
+}
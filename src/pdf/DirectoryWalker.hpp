@@ -0,0 +1,66 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <functional>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "BoundedQueue.hpp"
+#include "Common.hpp"
+#include "ThreadPool.hpp"
+
+namespace PDF
+{
+	/**
+	 * Enumerates files under a set of roots on a background thread and
+	 * streams the accepted ones into a queue while the walk goes on.
+	 * Each directory is listed by its own pool task, so subdirectories
+	 * are read in parallel. Symbolic links to directories are not followed.
+	 */
+	class DirectoryWalker
+	{
+	public:
+		using Path = boost::filesystem::path;
+		using Queue = BoundedQueue<Path>;
+		using Filter = std::function<bool(const Path &)>;
+
+		DirectoryWalker(std::vector<Path> roots, bool recursive, size_t threadCount, Filter filter);
+
+		DirectoryWalker(const DirectoryWalker &) = delete;
+
+		DirectoryWalker &operator=(const DirectoryWalker &) = delete;
+
+		~DirectoryWalker();
+
+		/// Starts the walk, the queue is closed once every root is listed
+		void Start(Queue &queue);
+
+		void Join();
+
+	private:
+		void Walk(Queue &queue);
+
+		void List(const Path &directory, Queue &queue);
+
+	private:
+		std::vector<Path> m_roots;
+
+		bool m_recursive;
+
+		size_t m_threadCount;
+
+		Filter m_filter;
+
+		std::unique_ptr<ThreadPool> m_pool;
+
+		std::thread m_thread;
+	};
+}
@@ -13,6 +13,32 @@ using PdfMemDocumentPtr = std::unique_ptr<PoDoFo::PdfMemDocument>;
 
 namespace PDF
 {
+	static std::vector<std::string> split(std::string &f, char by)
+	{
+		size_t                   begin{}, pos{};
+		std::vector<std::string> parts{};
+
+		while (begin < f.size())
+		{
+			if (pos == std::string::npos)
+			{
+				break;
+			}
+
+			pos = f.find(by, begin);
+
+			if (f.at(begin) == ' ')
+			{
+				++begin;
+			}
+
+			parts.push_back(f.substr(begin, pos - begin - 1));
+			begin = pos + 1;
+		}
+
+		return parts;
+	}
+
 	DocumentProperty::DocumentProperty(
 			std::string_view aTitle,
 			std::string_view aAuthor,
@@ -39,4 +65,30 @@ namespace PDF
 		pdfInfo->SetProducer(producer);
 		pdfInfo->SetKeywords(keywords);
 	}
+
+	DocumentProperty DocumentProperty::FromFileName(const boost::filesystem::path &path, char prefix)
+	{
+		auto             fileName = path.filename().generic_string();
+		DocumentProperty properties{};
+
+		if (auto index = fileName.find(prefix); index != std::string::npos)
+		{
+			fileName.erase(index, 1);
+		}
+		auto parts = split(fileName, '-');
+
+		if (!parts.empty())
+		{
+			if (parts.size() == 1)
+			{
+				properties = DocumentProperty("", parts.at(0));
+			}
+			else
+			{
+				properties = DocumentProperty(parts.at(1), parts.at(0));
+			}
+		}
+
+		return properties;
+	}
 }
\ No newline at end of file
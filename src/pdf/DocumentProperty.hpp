@@ -10,7 +10,9 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
+#include <boost/filesystem/path.hpp>
 #include <podofo/podofo.h>
 
 #include "Common.hpp"
@@ -41,5 +43,11 @@ namespace PDF
 		                 std::string_view aKeywords = {});
 		
 		void Populate(std::unique_ptr<PoDoFo::PdfMemDocument> &document) const;
+
+		/**
+		 * Properties named by a file called "Author-Title.pdf" once the
+		 * prefix character is dropped, a single part is the author.
+		 */
+		static DocumentProperty FromFileName(const boost::filesystem::path &path, char prefix);
 	};
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <iostream>
 
 #include "FileHandler.hpp"
+#include "ThreadPool.hpp"
 
 using namespace std;
 using namespace boost::program_options;
@@ -22,6 +23,33 @@ namespace PDF
 
 	static const char *g_pdfExtension{".pdf"};
 
+	/// Byte count with an optional K, M or G suffix
+	static size_t parseSize(const string &text)
+	{
+		size_t used{};
+		size_t value = stoull(text, &used);
+		auto   suffix = text.substr(used);
+
+		if (suffix.empty())
+		{
+			return value;
+		}
+
+		switch (toupper(static_cast<unsigned char>(suffix.front())))
+		{
+			case 'K':
+				return value << 10;
+			case 'M':
+				return value << 20;
+			case 'G':
+				return value << 30;
+			default:
+				throw invalid_argument("Invalid size '" + text + "'");
+		}
+	}
+
+	static constexpr size_t g_listBatch{1024};
+
 	FileHandler::
 	OptionsInfo::OptionsInfo(string_view aLongArg,
 	                         string_view aShortArg,
@@ -87,7 +115,28 @@ namespace PDF
 			: prefix{},
 			  pageNum{0},
 			  recursive{false},
-			  replace{false}
+			  replace{false},
+			  jobs{ThreadPool::DefaultSize()},
+			  incremental{false},
+			  mapped{false},
+			  pageJobs{1},
+			  cacheFile{},
+			  prefilter{false},
+			  walkJobs{ThreadPool::DefaultSize()},
+			  readJobs{2},
+			  parseJobs{ThreadPool::DefaultSize()},
+			  writeJobs{2},
+			  traceFile{},
+			  maxMemory{0},
+			  xrefStream{false},
+			  flateLevel{-1},
+			  encodeJobs{1},
+			  keepContents{false},
+			  serve{},
+			  arena{false},
+			  allocStats{false},
+			  pages{},
+			  ioUring{false}
 	{
 		this->info.emplace_back("help", "h", "Print help info");
 		this->info.emplace_back("dir", "d", "Directory to PDF files");
@@ -96,12 +145,35 @@ namespace PDF
 		this->info.emplace_back("number", "n", "Page number to start from");
 		this->info.emplace_back("replace", "R", "Replace original files with edited");
 		this->info.emplace_back("recursive", "r", "Parse recursive");
+		this->info.emplace_back("jobs", "j", "Number of threads cleaning parsed files (defaults to core count)");
+		this->info.emplace_back("incremental", "i", "Append only changed objects to a copy of the original file");
+		this->info.emplace_back("mmap", "m", "Read documents through a memory mapping");
+		this->info.emplace_back("page-jobs", "P", "Number of threads scanning the pages of one document");
+		this->info.emplace_back("cache", "c", "File keeping scan results to skip unchanged files");
+		this->info.emplace_back("prefilter", "f", "Skip files whose raw bytes cannot contain a match, any encoded /URI keeps a file");
+		this->info.emplace_back("walk-jobs", "W", "Number of threads listing directories");
+		this->info.emplace_back("read-jobs", "I", "Number of threads reading files ahead of parsing");
+		this->info.emplace_back("parse-jobs", "A", "Number of threads parsing files (defaults to core count)");
+		this->info.emplace_back("write-jobs", "O", "Number of threads writing cleaned files");
+		this->info.emplace_back("trace", "t", "Write per-file stage timings in Chrome trace format");
+		this->info.emplace_back("max-memory", "M", "Memory budget of documents in flight, e.g. 512M or 8G");
+		this->info.emplace_back("xref-stream", "x", "Write outputs with a compressed cross-reference stream");
+		this->info.emplace_back("flate-level", "z", "Compress unfiltered streams at this zlib level (0-9)");
+		this->info.emplace_back("encode-jobs", "E", "Number of threads compressing the streams of one document");
+		this->info.emplace_back("keep-contents", "K", "Leave content streams as they are, only drop resources");
+		this->info.emplace_back("serve", "S", "Serve JSON jobs on this Unix socket, or on standard input given -");
+		this->info.emplace_back("arena", "a", "Allocate per-document bookkeeping from an arena freed at once");
+		this->info.emplace_back("alloc-stats", "s", "Print allocation counts of every parsed file");
+		this->info.emplace_back("pages", "g", "Pages to clean from 1, e.g. 1-3,10,-5 where -5 is the last five");
+		this->info.emplace_back("io-uring", "U", "Read and write files through io_uring when built with it");
 	}
 
 	FileHandler::FileHandler(int argc, char **argv)
 			: m_argParser(argc, argv),
 			  m_options(),
-			  m_files()
+			  m_listed(false),
+			  m_files(),
+			  m_patterns(make_shared<const PatternSet>())
 	{
 		Init();
 	}
@@ -109,13 +181,17 @@ namespace PDF
 	FileHandler::FileHandler(const FileHandler &fh) noexcept
 			: m_argParser(fh.m_argParser),
 			  m_options(fh.m_options),
-			  m_files(fh.m_files)
+			  m_listed(fh.m_listed),
+			  m_files(fh.m_files),
+			  m_patterns(fh.m_patterns)
 	{}
 
 	FileHandler::FileHandler(FileHandler &&fh) noexcept
 			: m_argParser(std::move(fh.m_argParser)),
 			  m_options(std::move(fh.m_options)),
-			  m_files(std::move(fh.m_files))
+			  m_listed(fh.m_listed),
+			  m_files(std::move(fh.m_files)),
+			  m_patterns(std::move(fh.m_patterns))
 	{}
 
 	FileHandler &
@@ -148,6 +224,27 @@ namespace PDF
 		auto pageNumArg = m_options.info.at(4).longArg;
 		auto replArg    = m_options.info.at(5).longArg;
 		auto recArg     = m_options.info.at(6).longArg;
+		auto jobsArg    = m_options.info.at(7).longArg;
+		auto incrArg    = m_options.info.at(8).longArg;
+		auto mmapArg    = m_options.info.at(9).longArg;
+		auto pageJobArg = m_options.info.at(10).longArg;
+		auto cacheArg   = m_options.info.at(11).longArg;
+		auto filterArg  = m_options.info.at(12).longArg;
+		auto walkArg    = m_options.info.at(13).longArg;
+		auto readArg    = m_options.info.at(14).longArg;
+		auto parseArg   = m_options.info.at(15).longArg;
+		auto writeArg   = m_options.info.at(16).longArg;
+		auto traceArg   = m_options.info.at(17).longArg;
+		auto memoryArg  = m_options.info.at(18).longArg;
+		auto xrefArg    = m_options.info.at(19).longArg;
+		auto flateArg   = m_options.info.at(20).longArg;
+		auto encodeArg  = m_options.info.at(21).longArg;
+		auto keepArg    = m_options.info.at(22).longArg;
+		auto serveArg   = m_options.info.at(23).longArg;
+		auto arenaArg   = m_options.info.at(24).longArg;
+		auto allocArg   = m_options.info.at(25).longArg;
+		auto pagesArg   = m_options.info.at(26).longArg;
+		auto uringArg   = m_options.info.at(27).longArg;
 
 		if (not m_argParser.argc)
 		{
@@ -187,18 +284,139 @@ namespace PDF
 		{
 			m_options.recursive = m_argParser.variables[recArg].as<bool>();
 		}
+		// Jobs
+		if (m_argParser.variables.count(jobsArg))
+		{
+			auto jobs = m_argParser.variables[jobsArg].as<int>();
+			m_options.jobs = jobs > 0 ? static_cast<size_t>(jobs) : ThreadPool::DefaultSize();
+		}
+		// Incremental?
+		if (m_argParser.variables.count(incrArg))
+		{
+			m_options.incremental = m_argParser.variables[incrArg].as<bool>();
+		}
+		// Memory mapped?
+		if (m_argParser.variables.count(mmapArg))
+		{
+			m_options.mapped = m_argParser.variables[mmapArg].as<bool>();
+		}
+		// Page jobs
+		if (m_argParser.variables.count(pageJobArg))
+		{
+			auto jobs = m_argParser.variables[pageJobArg].as<int>();
+			m_options.pageJobs = jobs > 0 ? static_cast<size_t>(jobs) : ThreadPool::DefaultSize();
+		}
+		// Cache file
+		if (m_argParser.variables.count(cacheArg))
+		{
+			m_options.cacheFile = m_argParser.variables[cacheArg].as<string>();
+		}
+		// Prefilter?
+		if (m_argParser.variables.count(filterArg))
+		{
+			m_options.prefilter = m_argParser.variables[filterArg].as<bool>();
+		}
+		// Walk jobs
+		if (m_argParser.variables.count(walkArg))
+		{
+			auto jobs = m_argParser.variables[walkArg].as<int>();
+			m_options.walkJobs = jobs > 0 ? static_cast<size_t>(jobs) : ThreadPool::DefaultSize();
+		}
+		// Read jobs
+		if (m_argParser.variables.count(readArg))
+		{
+			auto jobs = m_argParser.variables[readArg].as<int>();
+			m_options.readJobs = jobs > 0 ? static_cast<size_t>(jobs) : 1;
+		}
+		// Parse jobs
+		if (m_argParser.variables.count(parseArg))
+		{
+			auto jobs = m_argParser.variables[parseArg].as<int>();
+			m_options.parseJobs = jobs > 0 ? static_cast<size_t>(jobs) : ThreadPool::DefaultSize();
+		}
+		// Write jobs
+		if (m_argParser.variables.count(writeArg))
+		{
+			auto jobs = m_argParser.variables[writeArg].as<int>();
+			m_options.writeJobs = jobs > 0 ? static_cast<size_t>(jobs) : 1;
+		}
+		// Trace file
+		if (m_argParser.variables.count(traceArg))
+		{
+			m_options.traceFile = m_argParser.variables[traceArg].as<string>();
+		}
+		// Memory budget
+		if (m_argParser.variables.count(memoryArg))
+		{
+			m_options.maxMemory = parseSize(m_argParser.variables[memoryArg].as<string>());
+		}
+		// Xref stream?
+		if (m_argParser.variables.count(xrefArg))
+		{
+			m_options.xrefStream = m_argParser.variables[xrefArg].as<bool>();
+		}
+		// Flate level
+		if (m_argParser.variables.count(flateArg))
+		{
+			auto level = m_argParser.variables[flateArg].as<int>();
+			if (level > 9)
+			{
+				throw invalid_argument("Flate level must be between 0 and 9");
+			}
+			m_options.flateLevel = level;
+		}
+		// Encode jobs
+		if (m_argParser.variables.count(encodeArg))
+		{
+			auto jobs = m_argParser.variables[encodeArg].as<int>();
+			m_options.encodeJobs = jobs > 0 ? static_cast<size_t>(jobs) : ThreadPool::DefaultSize();
+		}
+		// Keep contents?
+		if (m_argParser.variables.count(keepArg))
+		{
+			m_options.keepContents = m_argParser.variables[keepArg].as<bool>();
+		}
+		// Serve
+		if (m_argParser.variables.count(serveArg))
+		{
+			m_options.serve = m_argParser.variables[serveArg].as<string>();
+		}
+		// Arena?
+		if (m_argParser.variables.count(arenaArg))
+		{
+			m_options.arena = m_argParser.variables[arenaArg].as<bool>();
+		}
+		// Allocation stats?
+		if (m_argParser.variables.count(allocArg))
+		{
+			m_options.allocStats = m_argParser.variables[allocArg].as<bool>();
+		}
+		// Pages, throws std::invalid_argument on a malformed list
+		if (m_argParser.variables.count(pagesArg))
+		{
+			m_options.pages = PageSelection(m_argParser.variables[pagesArg].as<string>());
+		}
+		else
+		{
+			m_options.pages = PageSelection::From(m_options.pageNum);
+		}
+		// io_uring?
+		if (m_argParser.variables.count(uringArg))
+		{
+			m_options.ioUring = m_argParser.variables[uringArg].as<bool>();
+		}
 
-		if (not m_options.uris.empty() and not m_options.paths.empty())
+		// A server may get its patterns with each job instead
+		if ((not m_options.uris.empty() and not m_options.paths.empty()) or not m_options.serve.empty())
 		{
 			m_argParser.parsed = true;
+			m_patterns         = make_shared<const PatternSet>(m_options.uris);
 		}
 		else
 		{
 			Usage();
 			return;
 		}
-
-		ParseFilePaths();
 	}
 
 	void FileHandler::Usage() const
@@ -215,9 +433,33 @@ namespace PDF
 	const FileHandler::Files &
 	FileHandler::GetFiles() const
 	{
+		ParseFilePaths();
 		return m_files;
 	}
 
+	unique_ptr<DirectoryWalker> FileHandler::CreateWalker() const
+	{
+		vector<Path> roots(m_options.paths.begin(), m_options.paths.end());
+
+		return make_unique<DirectoryWalker>(std::move(roots), m_options.recursive, m_options.walkJobs,
+		                                    [this](const Path &path) { return IsInputFile(path); });
+	}
+
+	bool FileHandler::IsInputFile(const Path &path) const
+	{
+		if (path.has_extension() and path.extension().compare(g_pdfExtension))
+		{
+			return false;
+		}
+
+		return contains(path.filename().generic_string(), m_options.prefix);
+	}
+
+	PatternSetPtr FileHandler::GetPatterns() const
+	{
+		return m_patterns;
+	}
+
 	MAYBE_UNUSED
 	string_view FileHandler::GetUri(size_t index) const
 	{
@@ -282,40 +524,101 @@ namespace PDF
 						// Recursive -r
 						(m_options.info.at(6).ConcatArgs().data(),
 						 value<bool>()->implicit_value(true),
-						 m_options.info[6].description.data());
+						 m_options.info[6].description.data())
+						// Jobs -j
+						(m_options.info.at(7).ConcatArgs().data(),
+						 value<int>(), m_options.info[7].description.data())
+						// Incremental -i
+						(m_options.info.at(8).ConcatArgs().data(),
+						 value<bool>()->implicit_value(true),
+						 m_options.info[8].description.data())
+						// Memory mapped -m
+						(m_options.info.at(9).ConcatArgs().data(),
+						 value<bool>()->implicit_value(true),
+						 m_options.info[9].description.data())
+						// Page jobs -P
+						(m_options.info.at(10).ConcatArgs().data(),
+						 value<int>(), m_options.info[10].description.data())
+						// Cache -c
+						(m_options.info.at(11).ConcatArgs().data(),
+						 value<string>(), m_options.info[11].description.data())
+						// Prefilter -f
+						(m_options.info.at(12).ConcatArgs().data(),
+						 value<bool>()->implicit_value(true),
+						 m_options.info[12].description.data())
+						// Walk jobs -W
+						(m_options.info.at(13).ConcatArgs().data(),
+						 value<int>(), m_options.info[13].description.data())
+						// Read jobs -I
+						(m_options.info.at(14).ConcatArgs().data(),
+						 value<int>(), m_options.info[14].description.data())
+						// Parse jobs -A
+						(m_options.info.at(15).ConcatArgs().data(),
+						 value<int>(), m_options.info[15].description.data())
+						// Write jobs -O
+						(m_options.info.at(16).ConcatArgs().data(),
+						 value<int>(), m_options.info[16].description.data())
+						// Trace -t
+						(m_options.info.at(17).ConcatArgs().data(),
+						 value<string>(), m_options.info[17].description.data())
+						// Max memory -M
+						(m_options.info.at(18).ConcatArgs().data(),
+						 value<string>(), m_options.info[18].description.data())
+						// Xref stream -x
+						(m_options.info.at(19).ConcatArgs().data(),
+						 value<bool>()->implicit_value(true),
+						 m_options.info[19].description.data())
+						// Flate level -z
+						(m_options.info.at(20).ConcatArgs().data(),
+						 value<int>(), m_options.info[20].description.data())
+						// Encode jobs -E
+						(m_options.info.at(21).ConcatArgs().data(),
+						 value<int>(), m_options.info[21].description.data())
+						// Keep contents -K
+						(m_options.info.at(22).ConcatArgs().data(),
+						 value<bool>()->implicit_value(true),
+						 m_options.info[22].description.data())
+						// Serve -S
+						(m_options.info.at(23).ConcatArgs().data(),
+						 value<string>(), m_options.info[23].description.data())
+						// Arena -a
+						(m_options.info.at(24).ConcatArgs().data(),
+						 value<bool>()->implicit_value(true),
+						 m_options.info[24].description.data())
+						// Allocation stats -s
+						(m_options.info.at(25).ConcatArgs().data(),
+						 value<bool>()->implicit_value(true),
+						 m_options.info[25].description.data())
+						// Pages -g
+						(m_options.info.at(26).ConcatArgs().data(),
+						 value<string>(), m_options.info[26].description.data())
+						// io_uring -U
+						(m_options.info.at(27).ConcatArgs().data(),
+						 value<bool>()->implicit_value(true),
+						 m_options.info[27].description.data());
 	}
 
-	void FileHandler::ParseFilePaths()
+	void FileHandler::ParseFilePaths() const
 	{
 		std::lock_guard l(m_mutex);
 
-		for (auto &pathStr : m_options.paths)
+		if (m_listed)
 		{
-			auto path = Path(pathStr);
+			return;
+		}
 
-			if (not path.empty())
-			{
-				DirectoryIterator dirIter(path);
-
-				for (auto &iter : dirIter)
-				{
-					const auto &content = iter.path();
-
-					if (content.has_extension())
-					{
-						if (content.extension().compare(g_pdfExtension))
-						{
-							continue;
-						}
-					}
-
-					if (string fileName = content.filename().generic_string();
-							contains(fileName, m_options.prefix))
-					{
-						m_files.push_back(content.generic_string());
-					}
-				}
-			}
+		DirectoryWalker::Queue queue(g_listBatch);
+		auto               walker = CreateWalker();
+		Path               path;
+
+		walker->Start(queue);
+
+		while (queue.Pop(path))
+		{
+			m_files.push_back(std::move(path));
 		}
+
+		walker->Join();
+		m_listed = true;
 	}
 }
@@ -15,6 +15,9 @@
 #include <boost/program_options.hpp>
 
 #include "Common.hpp"
+#include "DirectoryWalker.hpp"
+#include "PageSelection.hpp"
+#include "Pattern.hpp"
 
 namespace PDF
 {
@@ -58,6 +61,49 @@ namespace PDF
 
 				bool replace{};
 
+				size_t jobs{};
+
+				bool incremental{};
+
+				bool mapped{};
+
+				size_t pageJobs{};
+
+				std::string cacheFile;
+
+				bool prefilter{};
+
+				size_t walkJobs{};
+
+				size_t readJobs{};
+
+				size_t parseJobs{};
+
+				size_t writeJobs{};
+
+				std::string traceFile;
+
+				size_t maxMemory{};
+
+				bool xrefStream{};
+
+				int flateLevel{};
+
+				size_t encodeJobs{};
+
+				bool keepContents{};
+
+				std::string serve;
+
+				bool arena{};
+
+				bool allocStats{};
+
+				/// Given by --pages, otherwise every page from --number on
+				PageSelection pages;
+
+				bool ioUring{};
+
 				std::vector<std::string> uris;
 
 				std::vector<std::string> paths;
@@ -107,8 +153,20 @@ namespace PDF
 		const ArgumentParser::Options &
 		GetOptions() const;
 
+		/// Enumerates every input file on first use, see CreateWalker()
 		const Files &GetFiles() const;
 
+		/// Walker streaming the input files of the given paths as they are found
+		NODISCARD
+		std::unique_ptr<DirectoryWalker> CreateWalker() const;
+
+		NODISCARD
+		bool IsInputFile(const Path &path) const;
+
+		/// Uri patterns compiled once by Parse(), shared by every file
+		NODISCARD
+		PatternSetPtr GetPatterns() const;
+
 		MAYBE_UNUSED
 		std::string_view GetUri(size_t index = 0) const;
 
@@ -119,7 +177,7 @@ namespace PDF
 	private:
 		void Init() noexcept;
 
-		void ParseFilePaths();
+		void ParseFilePaths() const;
 
 	private:
 		mutable std::mutex m_mutex;
@@ -128,6 +186,10 @@ namespace PDF
 
 		ArgumentParser::Options m_options;
 
-		Files m_files;
+		mutable bool m_listed;
+
+		mutable Files m_files;
+
+		PatternSetPtr m_patterns;
 	};
 }
@@ -0,0 +1,128 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <stdexcept>
+#include <vector>
+#include <zlib.h>
+
+#include "Flate.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	static void check(int result, const char *operation)
+	{
+		if (result != Z_OK and result != Z_STREAM_END and result != Z_BUF_ERROR)
+		{
+			throw runtime_error(string(operation) + " failed: " + zError(result));
+		}
+	}
+
+	string Flate::Deflate(string_view data, int level)
+	{
+		auto   bound = compressBound(static_cast<uLong>(data.size()));
+		string output(bound, '\0');
+
+		int result = compress2(reinterpret_cast<Bytef *>(output.data()), &bound,
+		                       reinterpret_cast<const Bytef *>(data.data()), static_cast<uLong>(data.size()),
+		                       level);
+
+		if (result != Z_OK)
+		{
+			throw runtime_error("Deflate failed: " + string(zError(result)));
+		}
+
+		output.resize(bound);
+		return output;
+	}
+
+	void Flate::Inflate(string_view data, size_t chunkSize, const Sink &sink)
+	{
+		z_stream     stream{};
+		vector<char> chunk(chunkSize);
+
+		check(inflateInit(&stream), "Inflate");
+
+		stream.next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+		stream.avail_in = static_cast<uInt>(data.size());
+
+		int result = Z_OK;
+		try
+		{
+			while (result != Z_STREAM_END)
+			{
+				stream.next_out  = reinterpret_cast<Bytef *>(chunk.data());
+				stream.avail_out = static_cast<uInt>(chunk.size());
+
+				result = inflate(&stream, Z_NO_FLUSH);
+				check(result, "Inflate");
+
+				auto produced = chunk.size() - stream.avail_out;
+				if (produced)
+				{
+					sink(string_view(chunk.data(), produced));
+				}
+				else if (result == Z_BUF_ERROR or not stream.avail_in)
+				{
+					// Truncated streams are common, what was decoded so far is kept
+					break;
+				}
+			}
+		}
+		catch (...)
+		{
+			inflateEnd(&stream);
+			throw;
+		}
+
+		inflateEnd(&stream);
+	}
+
+	Deflater::Deflater(int level)
+			: m_stream(make_unique<z_stream>()),
+			  m_output()
+	{
+		check(deflateInit(m_stream.get(), level), "Deflate");
+	}
+
+	Deflater::~Deflater()
+	{
+		deflateEnd(m_stream.get());
+	}
+
+	void Deflater::Write(string_view data)
+	{
+		Run(data, Z_NO_FLUSH);
+	}
+
+	string Deflater::Finish()
+	{
+		Run({}, Z_FINISH);
+		return std::move(m_output);
+	}
+
+	void Deflater::Run(string_view data, int flush)
+	{
+		char buffer[16 * 1024];
+
+		m_stream->next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+		m_stream->avail_in = static_cast<uInt>(data.size());
+
+		int result;
+		do
+		{
+			m_stream->next_out  = reinterpret_cast<Bytef *>(buffer);
+			m_stream->avail_out = sizeof(buffer);
+
+			result = deflate(m_stream.get(), flush);
+			check(result, "Deflate");
+			m_output.append(buffer, sizeof(buffer) - m_stream->avail_out);
+		} while (flush == Z_FINISH ? result != Z_STREAM_END : m_stream->avail_out == 0);
+	}
+}
@@ -0,0 +1,73 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "Common.hpp"
+
+struct z_stream_s;
+
+namespace PDF
+{
+	/// zlib compression at a chosen level, PoDoFo's own filter always uses the default
+	class Flate
+	{
+	public:
+		using Sink = std::function<void(std::string_view)>;
+
+		static constexpr int MinLevel = 0;
+
+		static constexpr int MaxLevel = 9;
+
+		/// zlib's own default, a trade-off between level 1 and 9
+		static constexpr int DefaultLevel = -1;
+
+		/// Throws std::runtime_error when zlib fails
+		NODISCARD
+		static std::string Deflate(std::string_view data, int level);
+
+		/**
+		 * Decodes data in pieces of at most chunkSize bytes handed to sink,
+		 * the decoded whole is never held at once. Throws std::runtime_error
+		 * on corrupt input.
+		 */
+		static void Inflate(std::string_view data, size_t chunkSize, const Sink &sink);
+	};
+
+	/// Incremental Flate encoder, appends compressed bytes as input arrives
+	class Deflater
+	{
+	public:
+		explicit Deflater(int level = Flate::DefaultLevel);
+
+		Deflater(const Deflater &) = delete;
+
+		Deflater &operator=(const Deflater &) = delete;
+
+		~Deflater();
+
+		void Write(std::string_view data);
+
+		/// Ends the stream and hands over everything compressed
+		NODISCARD
+		std::string Finish();
+
+	private:
+		void Run(std::string_view data, int flush);
+
+	private:
+		std::unique_ptr<z_stream_s> m_stream;
+
+		std::string m_output;
+	};
+}
@@ -6,9 +6,15 @@
  *  License-Identifier: MIT License
  *  See README.md for more information.
  */
+#include "ContentFilter.hpp"
+#include "Flate.hpp"
 #include "Inspector.hpp"
+#include "ThreadPool.hpp"
+#include "Trace.hpp"
 
+#include <atomic>
 #include <iostream>
+#include <sstream>
 #include <utility>
 
 using namespace std;
@@ -16,89 +22,425 @@ using namespace PoDoFo;
 
 namespace PDF
 {
-	bool matchesActionUri(PdfAction *action, string_view sv)
+	/// Pages handed to each scanning thread per batch
+	static constexpr int g_pagesPerJob = 4;
+
+	/// Raw stream bytes copied out of the document per compression batch
+	static constexpr size_t g_encodeBatchBytes = 64 * 1024 * 1024;
+
+	/// First block of a document arena, later ones grow geometrically
+	static constexpr size_t g_arenaBlock = 64 * 1024;
+
+	/// Whether annotation is a link whose /URI action matches pattern, read straight from its dictionary
+	static bool matchesActionUri(const PdfObject *annotation, const Pattern &pattern)
+	{
+		if (not annotation or not annotation->IsDictionary())
+		{
+			return false;
+		}
+
+		auto action = annotation->GetIndirectKey("A");
+		if (not action or not action->IsDictionary())
+		{
+			return false;
+		}
+
+		auto type = action->GetIndirectKey("S");
+		auto uri  = action->GetIndirectKey("URI");
+		if (not type or not type->IsName() or type->GetName() != PdfName("URI") or not uri or not uri->IsString())
+		{
+			return false;
+		}
+
+		return pattern.Matches(uri->GetString().GetStringUtf8());
+	}
+
+	/**
+	 * Resolves the content streams of a page and loads them with their
+	 * filter parameters, so that decoding them afterwards only reads.
+	 */
+	static vector<PdfObject *> loadContentStreams(PdfPage *page)
+	{
+		vector<PdfObject *> streams{};
+		PdfObject           *contents = page->GetContents();
+
+		auto load = [&streams, contents](PdfObject *object)
+		{
+			if (object->IsReference())
+			{
+				object = contents->GetOwner()->GetObject(object->GetReference());
+			}
+
+			if (object and object->HasStream())
+			{
+				object->GetIndirectKey(PdfName::KeyFilter);
+				object->GetIndirectKey("DecodeParms");
+				object->GetStream();
+				streams.push_back(object);
+			}
+		};
+
+		if (not contents)
+		{
+			return streams;
+		}
+
+		if (contents->IsArray())
+		{
+			for (auto &item : contents->GetArray())
+			{
+				load(&item);
+			}
+		}
+		else
+		{
+			load(contents);
+		}
+
+		return streams;
+	}
+
+	static string decodeContentStreams(const vector<PdfObject *> &streams)
+	{
+		string buffer{};
+
+		for (auto object : streams)
+		{
+			char     *data{};
+			pdf_long length{};
+
+			object->GetStream()->GetFilteredCopy(&data, &length);
+			buffer.append(data, static_cast<size_t>(length)).push_back('\n');
+			podofo_free(data);
+		}
+
+		return buffer;
+	}
+
+	Inspector::Inspector(boost::filesystem::path filePath, PatternSetPtr patterns, InspectorOptions options)
+			: m_arena(options.arena ? make_unique<pmr::monotonic_buffer_resource>(g_arenaBlock) : nullptr),
+			  m_state(State::Unedited),
+			  m_loaded(false),
+			  m_keyNames(),
+			  m_matchedNames(GetResource()),
+			  m_visited(GetResource()),
+			  m_forms(GetResource()),
+			  m_pending(),
+			  m_matchedKeys(),
+			  m_pages(),
+			  m_pattern(),
+			  m_patterns(std::move(patterns)),
+			  m_filePath(std::move(filePath)),
+			  m_options(options),
+			  m_contents(),
+			  m_mapping(),
+			  m_input(),
+			  m_document()
 	{
-		smatch m;
-		auto   uriRegex = regex(sv.data());
-		auto   uri      = action->GetURI().GetStringUtf8();
-		auto   res      = regex_search(uri, m, uriRegex);
-		return res;
+		Load();
 	}
 
-	Inspector::Inspector(boost::filesystem::path filePath)
-			: m_state(State::Unedited),
-			  m_keyName(),
+	Inspector::Inspector(boost::filesystem::path filePath, string contents,
+	                     PatternSetPtr patterns, InspectorOptions options)
+			: m_arena(options.arena ? make_unique<pmr::monotonic_buffer_resource>(g_arenaBlock) : nullptr),
+			  m_state(State::Unedited),
+			  m_loaded(false),
+			  m_keyNames(),
+			  m_matchedNames(GetResource()),
+			  m_visited(GetResource()),
+			  m_forms(GetResource()),
+			  m_pending(),
+			  m_matchedKeys(),
+			  m_pages(),
+			  m_pattern(),
+			  m_patterns(std::move(patterns)),
 			  m_filePath(std::move(filePath)),
+			  m_options(options),
+			  m_contents(std::move(contents)),
+			  m_mapping(),
+			  m_input(),
 			  m_document()
 	{
-		Init();
+		Load();
+	}
+
+	void Inspector::Delete(const Pattern &pattern, int pageIndex)
+	{
+		Delete(pattern, PageSelection::From(pageIndex));
 	}
 
-	void Inspector::Delete(string_view uri, int pageIndex)
+	void Inspector::Delete(const Pattern &pattern, const PageSelection &pages)
 	{
-		if (not m_document)
+		if (not Prepare(pages))
 		{
 			return;
 		}
 
-		if (not m_document->GetPageCount())
+		m_pattern = &pattern;
+
+		FindObjectName();
+
+		if (m_state == State::NoMatch)
 		{
-			cerr << "No pages in document \'" << m_filePath.filename().generic_string() << '\'';
 			return;
 		}
 
-		if (uri.empty())
+		RemoveMatches();
+	}
+
+	void Inspector::DeleteAll(int pageIndex)
+	{
+		DeleteAll(PageSelection::From(pageIndex));
+	}
+
+	void Inspector::DeleteAll(const PageSelection &pages)
+	{
+		if (not m_patterns or m_patterns->Empty())
 		{
 			return;
 		}
 
-		if (pageIndex < 0 or pageIndex > m_document->GetPageCount())
+		if (not Prepare(pages))
 		{
-			pageIndex = 0;
+			return;
 		}
 
-		m_uri = uri;
+		m_pattern = &m_patterns->GetCombined();
 
-		FindObjectName(pageIndex);
+		FindObjectNames();
 
 		if (m_state == State::NoMatch)
 		{
 			return;
 		}
 
-		PdfPage *page;
+		RemoveMatches();
+	}
 
-		for (; pageIndex < m_document->GetPageCount(); ++pageIndex)
+	bool Inspector::Load()
+	{
+		if (not m_loaded)
 		{
-			page = m_document->GetPage(pageIndex);
-			ProcessObject(page->GetObject());
-			for (int annotIndex{};
-			     annotIndex < page->GetNumAnnots();
-			     ++annotIndex)
-			{
-				DeleteAnnotation(page, annotIndex);
-			}
+			m_loaded = true;
+			Init();
 		}
-
-		m_keyName.clear();
+		return m_document != nullptr;
 	}
 
 	void Inspector::SetDocumentProperties(const DocumentProperty &props)
 	{
-		if (not m_document)
+		if (not Load())
 		{
 			return;
 		}
+
+		TraceSpan span("SetDocumentProperties", m_filePath.native());
 		props.Populate(m_document);
 	}
 
 	void Inspector::Write(string_view outputName)
 	{
-		if (not m_document)
+		if (not Load())
 		{
 			return;
 		}
-		m_document->Write(outputName.data());
+
+		string                    fileName(outputName);
+		TraceSpan                 span("Write", fileName);
+		boost::system::error_code error{};
+		bool                      inPlace = boost::filesystem::equivalent(m_filePath, fileName, error);
+
+		if (m_options.incremental)
+		{
+			// PoDoFo appends to a non-empty output and copies the original into an empty one,
+			// so a stale output from a previous run has to go first
+			if (not inPlace)
+			{
+				boost::filesystem::remove(fileName, error);
+			}
+			m_document->WriteUpdate(fileName.data());
+		}
+		else if (inPlace and m_mapping)
+		{
+			// Truncating the mapped source would fault on the objects still read from it
+			auto temporary = fileName + ".tmp";
+			CompressStreams();
+			WriteDocument(temporary);
+			boost::filesystem::rename(temporary, fileName);
+		}
+		else
+		{
+			CompressStreams();
+			WriteDocument(fileName);
+		}
+
+		if (Trace::IsEnabled())
+		{
+			auto size = boost::filesystem::file_size(fileName, error);
+			span.SetBytes(error ? -1 : static_cast<int64_t>(size));
+		}
+	}
+
+	void Inspector::CompressStreams()
+	{
+		if (m_options.flateLevel < Flate::MinLevel)
+		{
+			return;
+		}
+
+		TraceSpan span("Compress streams", m_filePath.native());
+		int       level = min(m_options.flateLevel, Flate::MaxLevel);
+		int64_t   saved{};
+
+		vector<PdfObject *> objects{};
+		for (auto object : *m_document->GetObjects())
+		{
+			if (not object or not object->HasStream())
+			{
+				continue;
+			}
+
+			// Filtered streams are kept byte for byte, XMP metadata stays readable as the spec recommends
+			auto &dictionary = object->GetDictionary();
+			if (dictionary.HasKey(PdfName::KeyFilter)
+			    or dictionary.GetKeyAsName(PdfName::KeyType) == PdfName("Metadata"))
+			{
+				continue;
+			}
+			objects.push_back(object);
+		}
+
+		auto pool = m_options.encodeJobs > 1 and objects.size() > 1
+		            ? make_unique<ThreadPool>(min(m_options.encodeJobs, objects.size()))
+		            : nullptr;
+
+		// Batches bound the raw copies held at once, only zlib runs on the pool
+		// since PoDoFo objects must not be touched from several threads
+		for (size_t begin{}; begin < objects.size();)
+		{
+			vector<string> raw{};
+			size_t         batchBytes{};
+			size_t         end = begin;
+
+			for (; end < objects.size() and (end == begin or batchBytes < g_encodeBatchBytes); ++end)
+			{
+				char     *data{};
+				pdf_long length{};
+
+				objects[end]->GetStream()->GetCopy(&data, &length);
+				raw.emplace_back(data, static_cast<size_t>(length));
+				podofo_free(data);
+				batchBytes += raw.back().size();
+			}
+
+			vector<string> packed(raw.size());
+			exception_ptr  failure{};
+			mutex          failureMutex{};
+
+			auto encode = [&](size_t index)
+			{
+				try
+				{
+					packed[index] = Flate::Deflate(raw[index], level);
+				}
+				catch (...)
+				{
+					lock_guard l(failureMutex);
+					failure = current_exception();
+				}
+			};
+
+			for (size_t index{}; index < raw.size(); ++index)
+			{
+				if (pool)
+				{
+					pool->Submit([&encode, index] { encode(index); });
+				}
+				else
+				{
+					encode(index);
+				}
+			}
+
+			if (pool)
+			{
+				pool->Wait();
+			}
+
+			if (failure)
+			{
+				rethrow_exception(failure);
+			}
+
+			// Stored in object order, so the output does not depend on scheduling
+			for (size_t index{}; index < raw.size(); ++index)
+			{
+				if (packed[index].size() >= raw[index].size())
+				{
+					continue;
+				}
+
+				auto           object = objects[begin + index];
+				PdfInputDevice device(packed[index].data(), packed[index].size());
+				object->GetStream()->SetRawData(&device, static_cast<pdf_long>(packed[index].size()));
+				object->GetDictionary().AddKey(PdfName::KeyFilter, PdfName("FlateDecode"));
+				saved += static_cast<int64_t>(raw[index].size() - packed[index].size());
+			}
+
+			begin = end;
+		}
+
+		span.SetBytes(saved);
+		span.SetCount(static_cast<int64_t>(objects.size()));
+	}
+
+	string Inspector::WriteToBuffer()
+	{
+		if (not Load())
+		{
+			return {};
+		}
+
+		TraceSpan    span("Write", m_filePath.native());
+		stringstream stream{};
+		{
+			PdfOutputDevice device(&stream);
+			CompressStreams();
+			WriteDocument(device);
+		}
+
+		auto contents = stream.str();
+		span.SetBytes(static_cast<int64_t>(contents.size()));
+		return contents;
+	}
+
+	void Inspector::WriteDocument(const string &fileName)
+	{
+		PdfOutputDevice device(fileName.data());
+		WriteDocument(device);
+	}
+
+	void Inspector::WriteDocument(PdfOutputDevice &device)
+	{
+		if (not m_options.xrefStream)
+		{
+			m_document->Write(&device);
+			return;
+		}
+
+		// Same as PdfMemDocument::Write apart from the xref layout, which needs PDF 1.5
+		PdfWriter writer(m_document->GetObjects(), m_document->GetTrailer());
+
+		writer.SetPdfVersion(max(m_document->GetPdfVersion(), ePdfVersion_1_5));
+		writer.SetWriteMode(m_document->GetWriteMode());
+		writer.SetUseXRefStream(true);
+
+		if (auto encrypt = m_document->GetEncrypt())
+		{
+			writer.SetEncrypted(*encrypt);
+		}
+
+		writer.Write(&device);
 	}
 
 	NODISCARD
@@ -124,12 +466,29 @@ namespace PDF
 		return (m_state == State::Deleted);
 	}
 
+	const KeywordMatcher::Keywords &Inspector::GetKeywords() const noexcept
+	{
+		return m_keyNames;
+	}
+
 	void Inspector::Init()
 	{
-		auto fileName = m_filePath.generic_string();
+		auto      fileName = m_filePath.generic_string();
+		TraceSpan span("Parse", fileName);
 		try
 		{
-			m_document = make_unique<PdfMemDocument>(fileName.data());
+			if (not m_contents.empty())
+			{
+				span.SetBytes(static_cast<int64_t>(m_contents.size()));
+				InitMemory(m_contents);
+				return;
+			}
+			if (m_options.mapped and InitMapped())
+			{
+				span.SetBytes(static_cast<int64_t>(m_mapping->View().size()));
+				return;
+			}
+			m_document = make_unique<PdfMemDocument>(fileName.data(), m_options.incremental);
 		}
 		catch (PdfError &error)
 		{
@@ -140,21 +499,201 @@ namespace PDF
 		}
 	}
 
-	void Inspector::FindObjectName(int pageIndex)
+	bool Inspector::InitMapped()
+	{
+		m_mapping = make_unique<MappedFile>(m_filePath);
+
+		if (not m_mapping->IsOpen())
+		{
+			m_mapping.reset();
+			return false;
+		}
+
+		InitMemory(m_mapping->View());
+		return true;
+	}
+
+	void Inspector::InitMemory(string_view data)
 	{
-		KeywordMatcher kwm(m_uri.data());
-		const int      pageCount = m_document->GetPageCount();
+		// The device reads straight from the memory, PoDoFo owns only the wrapper
+		m_input    = make_unique<MemoryInputStream>(data);
+		m_document = make_unique<PdfMemDocument>();
+		m_document->Load(PdfRefCountedInputDevice(new PdfInputDevice(m_input.get())), m_options.incremental);
+	}
+
+	bool Inspector::Prepare(const PageSelection &pages)
+	{
+		if (not Load())
+		{
+			return false;
+		}
+
+		if (not m_document->GetPageCount())
+		{
+			cerr << "No pages in document \'" << m_filePath.filename().generic_string() << '\'';
+			return false;
+		}
+
+		// The page count comes from the root of the page tree, GetPage() later
+		// resolves only the nodes leading to the selected pages
+		m_pages = pages.Resolve(m_document->GetPageCount());
+		if (m_pages.empty())
+		{
+			m_state = State::NoMatch;
+			return false;
+		}
+
+		return true;
+	}
+
+	void Inspector::FindObjectName()
+	{
+		TraceSpan span("FindObjectName", m_filePath.native());
+
+		if (UseParallelScan())
+		{
+			ScanPagesParallel(true);
+			return;
+		}
+
+		KeywordMatcher kwm(*m_pattern);
+		size_t         position{};
 
 		do
 		{
-			if (pageIndex >= pageCount)
+			if (position >= m_pages.size())
 			{
 				m_state = State::NoMatch;
 				break;
 			}
-			auto page = m_document->GetPage(pageIndex++);
+			auto page = m_document->GetPage(m_pages[position++]);
 			ReadObjectName(page, kwm);
 		} while (m_state != State::Ready);
+
+		span.SetCount(static_cast<int64_t>(position));
+	}
+
+	void Inspector::FindObjectNames()
+	{
+		TraceSpan span("FindObjectNames", m_filePath.native());
+
+		if (UseParallelScan())
+		{
+			ScanPagesParallel(false);
+			return;
+		}
+
+		span.SetCount(static_cast<int64_t>(m_pages.size()));
+
+		m_keyNames.clear();
+
+		for (int pageIndex : m_pages)
+		{
+			KeywordMatcher kwm(*m_pattern);
+			auto           tokenizer = make_unique<PdfContentsTokenizer>(m_document->GetPage(pageIndex));
+			kwm.FindMatches(tokenizer.get(), m_keyNames);
+		}
+
+		m_state = m_keyNames.empty() ? State::NoMatch : State::Ready;
+	}
+
+	bool Inspector::UseParallelScan() const
+	{
+		return m_options.pageJobs > 1 and m_pages.size() >= 2 * m_options.pageJobs;
+	}
+
+	void Inspector::ScanPagesParallel(bool firstOnly)
+	{
+		const int  pageCount = static_cast<int>(m_pages.size());
+		const int  batchSize = static_cast<int>(m_options.pageJobs) * g_pagesPerJob;
+		ThreadPool pool(m_options.pageJobs);
+
+		m_keyNames.clear();
+
+		// Batches run over positions in the selection, not over page numbers
+		for (int batchStart{}; batchStart < pageCount; batchStart += batchSize)
+		{
+			const int batchEnd = min(batchStart + batchSize, pageCount);
+			const int batchLength = batchEnd - batchStart;
+
+			// PoDoFo loads objects lazily and is not thread-safe, so everything
+			// the decoders touch is loaded here on the calling thread
+			vector<vector<PdfObject *>> contents(batchLength);
+			for (int offset{}; offset < batchLength; ++offset)
+			{
+				contents[offset] = loadContentStreams(m_document->GetPage(m_pages[batchStart + offset]));
+			}
+
+			vector<KeywordMatcher::Keywords> found(batchLength);
+			atomic<int>                      firstHit{batchLength};
+			exception_ptr                    failure{};
+			mutex                            failureMutex{};
+
+			for (int offset{}; offset < batchLength; ++offset)
+			{
+				pool.Submit([&, offset]
+				{
+					// Pages after a known match cannot change the result of a first-match scan
+					if (firstOnly and offset > firstHit.load())
+					{
+						return;
+					}
+
+					try
+					{
+						TraceSpan            span("Scan page", m_filePath.native());
+						auto                 buffer = decodeContentStreams(contents[offset]);
+						PdfContentsTokenizer tokenizer(buffer.data(), static_cast<long>(buffer.size()));
+						KeywordMatcher       kwm(*m_pattern);
+
+						span.SetBytes(static_cast<int64_t>(buffer.size()));
+						span.SetCount(m_pages[batchStart + offset]);
+
+						if (not firstOnly)
+						{
+							kwm.FindMatches(&tokenizer, found[offset]);
+						}
+						else if (kwm.FindMatch(&tokenizer))
+						{
+							found[offset].insert(string(kwm.GetKW()));
+
+							int current = firstHit.load();
+							while (offset < current and not firstHit.compare_exchange_weak(current, offset))
+							{}
+						}
+					}
+					catch (...)
+					{
+						lock_guard l(failureMutex);
+						failure = current_exception();
+					}
+				});
+			}
+
+			pool.Wait();
+
+			if (failure)
+			{
+				rethrow_exception(failure);
+			}
+
+			// Merged in page order, a first-match scan keeps only the earliest page
+			for (auto &keywords : found)
+			{
+				m_keyNames.insert(keywords.begin(), keywords.end());
+				if (firstOnly and not m_keyNames.empty())
+				{
+					break;
+				}
+			}
+
+			if (firstOnly and not m_keyNames.empty())
+			{
+				break;
+			}
+		}
+
+		m_state = m_keyNames.empty() ? State::NoMatch : State::Ready;
 	}
 
 	void Inspector::ReadObjectName(PdfPage *page, KeywordMatcher kwm)
@@ -162,56 +701,250 @@ namespace PDF
 		auto tokenizer = make_unique<PdfContentsTokenizer>(page);
 		if (kwm.FindMatch(tokenizer.get()))
 		{
-			m_keyName = kwm.GetKW();
-			m_state   = State::Ready;
+			m_keyNames = {string(kwm.GetKW())};
+			m_state    = State::Ready;
+		}
+	}
+
+	void Inspector::RemoveMatches()
+	{
+		PdfPage *page;
+
+		m_matchedNames.clear();
+		m_visited.clear();
+		m_forms.clear();
+
+		for (const auto &name : m_keyNames)
+		{
+			m_matchedNames.emplace(name);
+		}
+
+		{
+			TraceSpan span("ProcessDictionary", m_filePath.native());
+
+			for (int pageIndex : m_pages)
+			{
+				page = m_document->GetPage(pageIndex);
+				ProcessObject(page->GetObject());
+
+				// Resources inherited from the page tree are not reachable from the page itself
+				if (auto resources = page->GetResources();
+						resources and not page->GetObject()->GetDictionary().HasKey("Resources"))
+				{
+					ProcessObject(resources);
+				}
+			}
+
+			span.SetCount(static_cast<int64_t>(m_visited.size()));
+		}
+
+		if (m_options.rewriteContents)
+		{
+			RewriteContents();
+		}
+
+		TraceSpan                    span("Delete annotations", m_filePath.native());
+		pmr::map<PdfReference, bool> matches(GetResource());
+		int64_t                      deleted{};
+
+		for (int pageIndex : m_pages)
+		{
+			deleted += static_cast<int64_t>(DeleteAnnotations(m_document->GetPage(pageIndex), matches));
 		}
+
+		// Pages outside the selection may share annotations, their objects are
+		// then left unreferenced rather than reading every other page
+		if (static_cast<int>(m_pages.size()) == m_document->GetPageCount())
+		{
+			auto objects = m_document->GetObjects();
+			for (const auto &[reference, matched] : matches)
+			{
+				if (matched)
+				{
+					delete objects->RemoveObject(reference);
+				}
+			}
+		}
+
+		span.SetCount(deleted);
 	}
 
-	void Inspector::DeleteAnnotation(PdfPage *page, int index)
+	void Inspector::RewriteContents()
 	{
-		auto     annot  = page->GetAnnotation(index);
-		if (auto action = annot->GetAction(); action && action->HasURI())
+		const int             level     = m_options.flateLevel >= 0 ? m_options.flateLevel : Flate::DefaultLevel;
+		TraceSpan             span("Rewrite contents", m_filePath.native());
+		ContentRewriter       rewriter(m_keyNames, level);
+		pmr::set<PdfObject *> seen(GetResource());
+		int64_t               rewritten{};
+
+		auto rewrite = [&](PdfObject *object)
 		{
-			if (matchesActionUri(annot->GetAction(), m_uri))
+			// Pages may share content streams
+			if (seen.insert(object).second and rewriter.Rewrite(object))
 			{
-				page->DeleteAnnotation(index);
+				++rewritten;
+				m_state = State::Deleted;
+			}
+		};
+
+		for (int pageIndex : m_pages)
+		{
+			for (auto object : loadContentStreams(m_document->GetPage(pageIndex)))
+			{
+				rewrite(object);
 			}
 		}
+
+		for (auto form : m_forms)
+		{
+			rewrite(form);
+		}
+
+		span.SetCount(rewritten);
 	}
 
-	void Inspector::ProcessObject(PdfObject *object)
+	size_t Inspector::DeleteAnnotations(PdfPage *page, pmr::map<PdfReference, bool> &matches)
 	{
-		if (object->GetDataType() == EPdfDataType::ePdfDataType_Dictionary)
+		auto annotations = page->GetObject()->GetIndirectKey("Annots");
+		if (not annotations or not annotations->IsArray())
+		{
+			return 0;
+		}
+
+		auto   &array  = annotations->GetArray();
+		auto   objects = m_document->GetObjects();
+		size_t kept{};
+
+		// Every annotation is classified first, then the array is compacted once
+		for (size_t index{}; index < array.size(); ++index)
+		{
+			auto &item = array[index];
+			bool matched;
+
+			if (item.IsReference())
+			{
+				// Classified once for all the pages referring to it
+				auto [iter, inserted] = matches.try_emplace(item.GetReference(), false);
+				if (inserted)
+				{
+					iter->second = matchesActionUri(objects->GetObject(item.GetReference()), *m_pattern);
+				}
+				matched = iter->second;
+			}
+			else
+			{
+				matched = matchesActionUri(&item, *m_pattern);
+			}
+
+			if (not matched)
+			{
+				if (kept != index)
+				{
+					array[kept] = item;
+				}
+				++kept;
+			}
+		}
+
+		auto count = array.size() - kept;
+		if (not count)
 		{
-			ProcessDictionary(&object->GetDictionary());
+			return 0;
 		}
+
+		array.erase(array.begin() + static_cast<ptrdiff_t>(kept), array.end());
+
+		m_state = State::Deleted;
+		return count;
 	}
 
-	void Inspector::ProcessDictionary(PdfDictionary *dictionary)
+	void Inspector::ProcessObject(PdfObject *object)
 	{
-		PdfName objectKeyName(m_keyName);
-		
-		try
+		m_pending.assign({object});
+
+		while (not m_pending.empty())
 		{
-			for(auto& [key, object]: dictionary->GetKeys())
+			object = m_pending.back();
+			m_pending.pop_back();
+
+			if (not object)
 			{
-				if(!object)
-					return;
-				
-				if(key == objectKeyName)
+				continue;
+			}
+
+			if (object->IsReference())
+			{
+				if (not m_visited.insert(object->GetReference()).second)
 				{
-					bool removed = dictionary->RemoveKey(objectKeyName);
-					if(removed)
-					{
-						m_state = State::Deleted;
-					}
 					continue;
 				}
-				ProcessObject(object);
+				object = m_document->GetObjects()->GetObject(object->GetReference());
+			}
+			else if (object->Reference().IsIndirect()
+			         and not m_visited.insert(object->Reference()).second)
+			{
+				continue;
+			}
+
+			if (not object)
+			{
+				continue;
+			}
+
+			if (object->IsDictionary())
+			{
+				// HasStream() loads a delayed stream, so it is left for the forms
+				// instead of running on every image and font reached
+				if (object->GetDictionary().GetKeyAsName("Subtype") == PdfName("Form") and object->HasStream())
+				{
+					m_forms.push_back(object);
+				}
+
+				ProcessDictionary(&object->GetDictionary());
+			}
+			else if (object->IsArray())
+			{
+				for (auto &item : object->GetArray())
+				{
+					m_pending.push_back(&item);
+				}
+			}
+		}
+	}
+
+	void Inspector::ProcessDictionary(PdfDictionary *dictionary)
+	{
+		// Links back up the page tree or across annotations and outlines,
+		// following them would walk most of the document from every page
+		static const set<PdfName> skippedKeys{"Parent", "P", "Annots", "Popup", "Prev", "Next", "First", "Last",
+		                                      "Dest"};
+
+		m_matchedKeys.clear();
+
+		for (auto &[key, object] : dictionary->GetKeys())
+		{
+			if (m_matchedNames.count(key))
+			{
+				m_matchedKeys.push_back(key);
+			}
+			else if (not skippedKeys.count(key))
+			{
+				m_pending.push_back(object);
 			}
-		} catch(exception &e)
+		}
+
+		// Removing while iterating would invalidate the key map iterators
+		for (auto &key : m_matchedKeys)
 		{
-			printf("Exception was thrown: %s", e.what());
+			if (dictionary->RemoveKey(key))
+			{
+				m_state = State::Deleted;
+			}
 		}
 	}
+
+	pmr::memory_resource *Inspector::GetResource() const noexcept
+	{
+		return m_arena ? m_arena.get() : pmr::get_default_resource();
+	}
 }
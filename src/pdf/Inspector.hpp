@@ -8,15 +8,49 @@
  */
 #pragma once
 
+#include <map>
 #include <memory>
+#include <memory_resource>
+#include <set>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <podofo/podofo.h>
 
 #include "DocumentProperty.hpp"
 #include "Keyword.hpp"
+#include "MappedFile.hpp"
+#include "PageSelection.hpp"
+#include "Pattern.hpp"
 
 namespace PDF
 {
+	struct InspectorOptions
+	{
+		/// Write changed objects as an incremental update of the original file
+		bool incremental{};
+
+		/// Parse from a memory mapping of the file, falls back to reading the path
+		bool mapped{};
+
+		/// Threads decoding and scanning the pages of one document
+		size_t pageJobs{1};
+
+		/// Write a cross-reference stream instead of a classic xref table
+		bool xrefStream{};
+
+		/// Flate level for streams stored without a filter, negative leaves them as they are
+		int flateLevel{-1};
+
+		/// Threads compressing the streams of one document before it is written
+		size_t encodeJobs{1};
+
+		/// Drop the Do, sh and gs operations naming a removed resource from content streams
+		bool rewriteContents{true};
+
+		/// Allocate the inspector's own per-document data from an arena released in one step
+		bool arena{};
+	};
+
 	class Inspector
 	{
 		enum State
@@ -27,14 +61,40 @@ namespace PDF
 			NoMatch   // document doesn't contain search data
 		};
 	public:
-		explicit Inspector(boost::filesystem::path filePath);
+		Inspector(boost::filesystem::path filePath, PatternSetPtr patterns, InspectorOptions options = {});
+
+		/// Parses the already read contents of filePath instead of opening it
+		Inspector(boost::filesystem::path filePath, std::string contents,
+		          PatternSetPtr patterns, InspectorOptions options = {});
+
+		/// Every page from the zero-based pageIndex on
+		void Delete(const Pattern &pattern, int pageIndex = 0);
 
-		void Delete(std::string_view uri, int pageIndex = 0);
+		void Delete(const Pattern &pattern, const PageSelection &pages);
+
+		/**
+		 * Deletes the matches of every pattern of the set
+		 * walking pages, content streams and annotations once.
+		 */
+		void DeleteAll(int pageIndex = 0);
+
+		void DeleteAll(const PageSelection &pages);
+
+		/**
+		 * Parses the document unless already done. Only the xref is read here,
+		 * PoDoFo resolves objects and streams when they are first accessed.
+		 * Returns false if the document cannot be opened.
+		 */
+		bool Load();
 
 		void SetDocumentProperties(const DocumentProperty &props);
 
 		void Write(std::string_view outputName);
 
+		/// Writes the whole document to memory, the incremental option does not apply
+		NODISCARD
+		std::string WriteToBuffer();
+
 		NODISCARD
 		MAYBE_UNUSED
 		std::string GetStructure() const;
@@ -42,28 +102,105 @@ namespace PDF
 		NODISCARD
 		bool Done() const;
 
+		/// Keyword names matched by the last search
+		NODISCARD
+		const KeywordMatcher::Keywords &GetKeywords() const noexcept;
+
 	private:
 		void Init();
 
-		void FindObjectName(int pageIndex = 0);
+		bool InitMapped();
 
-		void ReadObjectName(PoDoFo::PdfPage *page, KeywordMatcher kwm);
+		void InitMemory(std::string_view data);
+
+		/// Compresses unfiltered streams at the configured level, in parallel when asked
+		void CompressStreams();
+
+		void WriteDocument(const std::string &fileName);
+
+		void WriteDocument(PoDoFo::PdfOutputDevice &device);
+
+		/// Loads the document and resolves the selected pages, false when there is nothing to do
+		bool Prepare(const PageSelection &pages);
 
-		void DeleteAnnotation(PoDoFo::PdfPage *page, int index);
+		void FindObjectName();
 
+		void FindObjectNames();
+
+		NODISCARD
+		bool UseParallelScan() const;
+
+		void ScanPagesParallel(bool firstOnly);
+
+		void RemoveMatches();
+
+		/// Filters page content streams and the form XObjects found by ProcessObject()
+		void RewriteContents();
+
+		void ReadObjectName(PoDoFo::PdfPage *page, KeywordMatcher kwm);
+
+		/**
+		 * Rebuilds the /Annots of page once without the matching links and
+		 * returns how many went. Indirect annotations are classified once
+		 * into matches, the caller may remove the matched objects afterwards.
+		 */
+		size_t DeleteAnnotations(PoDoFo::PdfPage *page, std::pmr::map<PoDoFo::PdfReference, bool> &matches);
+
+		/**
+		 * Removes matched names from every dictionary reachable from object.
+		 * Indirect objects are resolved and walked once per document.
+		 */
 		void ProcessObject(PoDoFo::PdfObject *object);
 
+		/// Queues the values of dictionary on m_pending, dropping the matched keys
 		void ProcessDictionary(PoDoFo::PdfDictionary *dictionary);
 
+		/// The arena when enabled, the default resource otherwise
+		NODISCARD
+		std::pmr::memory_resource *GetResource() const noexcept;
+
 	private:
+		// Declared first, everything allocated from it is gone before it is released
+		std::unique_ptr<std::pmr::monotonic_buffer_resource> m_arena;
+
 		State m_state;
 
-		std::string m_keyName;
+		bool m_loaded;
+
+		KeywordMatcher::Keywords m_keyNames;
 
-		std::string_view m_uri;
+		// Matched names as PDF names and the indirect objects already walked
+		std::pmr::set<PoDoFo::PdfName> m_matchedNames;
+
+		std::pmr::set<PoDoFo::PdfReference> m_visited;
+
+		// Form XObjects met while walking, their content names resources too
+		std::pmr::vector<PoDoFo::PdfObject *> m_forms;
+
+		// Scratch of ProcessObject() and ProcessDictionary(), kept off the arena
+		// so that their capacity is reused instead of growing it on every call
+		std::vector<PoDoFo::PdfObject *> m_pending;
+
+		std::vector<PoDoFo::PdfName> m_matchedKeys;
+
+		// Zero-based indices of the pages worked on, see Prepare()
+		std::vector<int> m_pages;
+
+		const Pattern *m_pattern;
+
+		PatternSetPtr m_patterns;
 
 		boost::filesystem::path m_filePath;
 
+		InspectorOptions m_options;
+
+		// Declared before the document, which reads from them until destroyed
+		std::string m_contents;
+
+		std::unique_ptr<MappedFile> m_mapping;
+
+		std::unique_ptr<MemoryInputStream> m_input;
+
 		std::unique_ptr<PoDoFo::PdfMemDocument> m_document;
 	};
 }
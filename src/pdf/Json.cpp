@@ -0,0 +1,586 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "Json.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	/// Nesting accepted by the parser, deeper input is rejected rather than overflowing the stack
+	static constexpr int g_maxDepth = 64;
+
+	class JsonParser
+	{
+	public:
+		explicit JsonParser(string_view text)
+				: m_text(text),
+				  m_position()
+		{}
+
+		Json ParseDocument()
+		{
+			auto value = ParseValue(0);
+
+			SkipSpace();
+			if (m_position != m_text.size())
+			{
+				Fail("Unexpected data after the value");
+			}
+			return value;
+		}
+
+	private:
+		[[noreturn]] void Fail(const char *message) const
+		{
+			throw invalid_argument(string("JSON: ") + message + " at offset " + to_string(m_position));
+		}
+
+		void SkipSpace() noexcept
+		{
+			while (m_position < m_text.size()
+			       and (m_text[m_position] == ' ' or m_text[m_position] == '\t'
+			            or m_text[m_position] == '\n' or m_text[m_position] == '\r'))
+			{
+				++m_position;
+			}
+		}
+
+		char Peek()
+		{
+			SkipSpace();
+			if (m_position == m_text.size())
+			{
+				Fail("Unexpected end");
+			}
+			return m_text[m_position];
+		}
+
+		void Expect(string_view word)
+		{
+			if (m_text.substr(m_position, word.size()) != word)
+			{
+				Fail("Invalid literal");
+			}
+			m_position += word.size();
+		}
+
+		Json ParseValue(int depth)
+		{
+			if (depth > g_maxDepth)
+			{
+				Fail("Nesting too deep");
+			}
+
+			switch (Peek())
+			{
+				case '{':
+					return ParseObject(depth);
+				case '[':
+					return ParseArray(depth);
+				case '"':
+					return ParseString();
+				case 't':
+					Expect("true");
+					return true;
+				case 'f':
+					Expect("false");
+					return false;
+				case 'n':
+					Expect("null");
+					return {};
+				default:
+					return ParseNumber();
+			}
+		}
+
+		Json ParseObject(int depth)
+		{
+			Json::Object object{};
+
+			++m_position;
+			if (Peek() == '}')
+			{
+				++m_position;
+				return object;
+			}
+
+			for (;;)
+			{
+				if (Peek() != '"')
+				{
+					Fail("Expected a key");
+				}
+				auto key = ParseString();
+
+				if (Peek() != ':')
+				{
+					Fail("Expected ':'");
+				}
+				++m_position;
+				object[key] = ParseValue(depth + 1);
+
+				auto next = Peek();
+				++m_position;
+				if (next == '}')
+				{
+					return object;
+				}
+				if (next != ',')
+				{
+					Fail("Expected ',' or '}'");
+				}
+			}
+		}
+
+		Json ParseArray(int depth)
+		{
+			Json::Array array{};
+
+			++m_position;
+			if (Peek() == ']')
+			{
+				++m_position;
+				return array;
+			}
+
+			for (;;)
+			{
+				array.push_back(ParseValue(depth + 1));
+
+				auto next = Peek();
+				++m_position;
+				if (next == ']')
+				{
+					return array;
+				}
+				if (next != ',')
+				{
+					Fail("Expected ',' or ']'");
+				}
+			}
+		}
+
+		unsigned ParseHex()
+		{
+			unsigned code{};
+
+			for (int digit{}; digit < 4; ++digit, ++m_position)
+			{
+				if (m_position == m_text.size())
+				{
+					Fail("Unexpected end");
+				}
+
+				char c = m_text[m_position];
+				code <<= 4;
+				if (c >= '0' and c <= '9')
+				{
+					code |= static_cast<unsigned>(c - '0');
+				}
+				else if (c >= 'a' and c <= 'f')
+				{
+					code |= static_cast<unsigned>(c - 'a' + 10);
+				}
+				else if (c >= 'A' and c <= 'F')
+				{
+					code |= static_cast<unsigned>(c - 'A' + 10);
+				}
+				else
+				{
+					Fail("Invalid \\u escape");
+				}
+			}
+
+			return code;
+		}
+
+		static void AppendUtf8(string &text, unsigned code)
+		{
+			if (code < 0x80)
+			{
+				text.push_back(static_cast<char>(code));
+			}
+			else if (code < 0x800)
+			{
+				text.push_back(static_cast<char>(0xC0 | (code >> 6)));
+				text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+			else if (code < 0x10000)
+			{
+				text.push_back(static_cast<char>(0xE0 | (code >> 12)));
+				text.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+				text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+			else
+			{
+				text.push_back(static_cast<char>(0xF0 | (code >> 18)));
+				text.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+				text.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+				text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+		}
+
+		string ParseString()
+		{
+			string text{};
+
+			++m_position;
+			for (;;)
+			{
+				if (m_position == m_text.size())
+				{
+					Fail("Unterminated string");
+				}
+
+				char c = m_text[m_position++];
+				if (c == '"')
+				{
+					return text;
+				}
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					Fail("Control character in string");
+				}
+				if (c != '\\')
+				{
+					text.push_back(c);
+					continue;
+				}
+
+				if (m_position == m_text.size())
+				{
+					Fail("Unterminated string");
+				}
+
+				switch (m_text[m_position++])
+				{
+					case '"':
+						text.push_back('"');
+						break;
+					case '\\':
+						text.push_back('\\');
+						break;
+					case '/':
+						text.push_back('/');
+						break;
+					case 'b':
+						text.push_back('\b');
+						break;
+					case 'f':
+						text.push_back('\f');
+						break;
+					case 'n':
+						text.push_back('\n');
+						break;
+					case 'r':
+						text.push_back('\r');
+						break;
+					case 't':
+						text.push_back('\t');
+						break;
+					case 'u':
+					{
+						auto code = ParseHex();
+
+						// Characters outside the basic plane come as a surrogate pair
+						if (code >= 0xD800 and code < 0xDC00 and m_text.substr(m_position, 2) == "\\u")
+						{
+							m_position += 2;
+							auto low = ParseHex();
+							if (low < 0xDC00 or low >= 0xE000)
+							{
+								Fail("Invalid surrogate pair");
+							}
+							code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+						}
+						AppendUtf8(text, code);
+						break;
+					}
+					default:
+						Fail("Invalid escape");
+				}
+			}
+		}
+
+		Json ParseNumber()
+		{
+			auto begin = m_position;
+
+			while (m_position < m_text.size())
+			{
+				char c = m_text[m_position];
+				if ((c < '0' or c > '9') and c != '-' and c != '+' and c != '.' and c != 'e' and c != 'E')
+				{
+					break;
+				}
+				++m_position;
+			}
+
+			if (begin == m_position)
+			{
+				Fail("Unexpected character");
+			}
+
+			string token(m_text.substr(begin, m_position - begin));
+			char   *end{};
+			double value = strtod(token.c_str(), &end);
+
+			if (end != token.c_str() + token.size())
+			{
+				m_position = begin;
+				Fail("Invalid number");
+			}
+			return value;
+		}
+
+	private:
+		string_view m_text;
+
+		size_t m_position;
+	};
+
+	Json::Json() noexcept
+			: m_type(Type::Null),
+			  m_bool(),
+			  m_number(),
+			  m_string(),
+			  m_array(),
+			  m_object()
+	{}
+
+	Json::Json(bool value) noexcept
+			: Json()
+	{
+		m_type = Type::Bool;
+		m_bool = value;
+	}
+
+	Json::Json(double value) noexcept
+			: Json()
+	{
+		m_type   = Type::Number;
+		m_number = value;
+	}
+
+	Json::Json(string value)
+			: Json()
+	{
+		m_type   = Type::String;
+		m_string = std::move(value);
+	}
+
+	Json::Json(const char *value)
+			: Json(string(value))
+	{}
+
+	Json::Json(Array value)
+			: Json()
+	{
+		m_type  = Type::Array;
+		m_array = std::move(value);
+	}
+
+	Json::Json(Object value)
+			: Json()
+	{
+		m_type   = Type::Object;
+		m_object = std::move(value);
+	}
+
+	Json Json::Parse(string_view text)
+	{
+		return JsonParser(text).ParseDocument();
+	}
+
+	string Json::Dump() const
+	{
+		string text{};
+		Dump(text);
+		return text;
+	}
+
+	Json::Type Json::GetType() const noexcept
+	{
+		return m_type;
+	}
+
+	bool Json::IsNull() const noexcept
+	{
+		return m_type == Type::Null;
+	}
+
+	bool Json::AsBool() const
+	{
+		if (m_type != Type::Bool)
+		{
+			throw invalid_argument("JSON: expected a boolean");
+		}
+		return m_bool;
+	}
+
+	double Json::AsNumber() const
+	{
+		if (m_type != Type::Number)
+		{
+			throw invalid_argument("JSON: expected a number");
+		}
+		return m_number;
+	}
+
+	const string &Json::AsString() const
+	{
+		if (m_type != Type::String)
+		{
+			throw invalid_argument("JSON: expected a string");
+		}
+		return m_string;
+	}
+
+	const Json::Array &Json::AsArray() const
+	{
+		if (m_type != Type::Array)
+		{
+			throw invalid_argument("JSON: expected an array");
+		}
+		return m_array;
+	}
+
+	const Json::Object &Json::AsObject() const
+	{
+		if (m_type != Type::Object)
+		{
+			throw invalid_argument("JSON: expected an object");
+		}
+		return m_object;
+	}
+
+	const Json &Json::operator[](const string &key) const
+	{
+		static const Json null{};
+
+		if (m_type != Type::Object)
+		{
+			return null;
+		}
+
+		auto found = m_object.find(key);
+		return found == m_object.end() ? null : found->second;
+	}
+
+	Json &Json::operator[](const string &key)
+	{
+		if (m_type == Type::Null)
+		{
+			m_type = Type::Object;
+		}
+		else if (m_type != Type::Object)
+		{
+			throw invalid_argument("JSON: expected an object");
+		}
+		return m_object[key];
+	}
+
+	static void dumpString(string &text, string_view value)
+	{
+		text.push_back('"');
+		for (char c : value)
+		{
+			switch (c)
+			{
+				case '"':
+					text.append("\\\"");
+					break;
+				case '\\':
+					text.append("\\\\");
+					break;
+				case '\n':
+					text.append("\\n");
+					break;
+				case '\r':
+					text.append("\\r");
+					break;
+				case '\t':
+					text.append("\\t");
+					break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20)
+					{
+						char code[8];
+						snprintf(code, sizeof(code), "\\u%04x", c);
+						text.append(code);
+					}
+					else
+					{
+						text.push_back(c);
+					}
+			}
+		}
+		text.push_back('"');
+	}
+
+	void Json::Dump(string &text) const
+	{
+		switch (m_type)
+		{
+			case Type::Null:
+				text.append("null");
+				break;
+			case Type::Bool:
+				text.append(m_bool ? "true" : "false");
+				break;
+			case Type::Number:
+			{
+				// JSON has no infinities nor NaN
+				char number[32];
+				snprintf(number, sizeof(number), "%.9g", isfinite(m_number) ? m_number : 0.0);
+				text.append(number);
+				break;
+			}
+			case Type::String:
+				dumpString(text, m_string);
+				break;
+			case Type::Array:
+				text.push_back('[');
+				for (size_t index{}; index < m_array.size(); ++index)
+				{
+					if (index)
+					{
+						text.push_back(',');
+					}
+					m_array[index].Dump(text);
+				}
+				text.push_back(']');
+				break;
+			case Type::Object:
+			{
+				bool first = true;
+
+				text.push_back('{');
+				for (const auto &[key, value] : m_object)
+				{
+					if (not first)
+					{
+						text.push_back(',');
+					}
+					first = false;
+					dumpString(text, key);
+					text.push_back(':');
+					value.Dump(text);
+				}
+				text.push_back('}');
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,106 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Common.hpp"
+
+namespace PDF
+{
+	/**
+	 * Minimal JSON value, enough for the job protocol of the server.
+	 * Numbers are doubles and object keys are kept sorted.
+	 */
+	class Json
+	{
+	public:
+		enum class Type
+		{
+			Null,
+			Bool,
+			Number,
+			String,
+			Array,
+			Object
+		};
+
+		using Array = std::vector<Json>;
+
+		using Object = std::map<std::string, Json>;
+
+		Json() noexcept;
+
+		Json(bool value) noexcept;
+
+		Json(double value) noexcept;
+
+		Json(std::string value);
+
+		Json(const char *value);
+
+		Json(Array value);
+
+		Json(Object value);
+
+		/// Throws std::invalid_argument on malformed text
+		static Json Parse(std::string_view text);
+
+		/// Single line text of the value
+		NODISCARD
+		std::string Dump() const;
+
+		NODISCARD
+		Type GetType() const noexcept;
+
+		NODISCARD
+		bool IsNull() const noexcept;
+
+		/// The As accessors throw std::invalid_argument on a value of another type
+		NODISCARD
+		bool AsBool() const;
+
+		NODISCARD
+		double AsNumber() const;
+
+		NODISCARD
+		const std::string &AsString() const;
+
+		NODISCARD
+		const Array &AsArray() const;
+
+		NODISCARD
+		const Object &AsObject() const;
+
+		/// Member of an object, null when missing or when this is not an object
+		const Json &operator[](const std::string &key) const;
+
+		/// Member of an object, a null value turns into an empty object first
+		Json &operator[](const std::string &key);
+
+	private:
+		void Dump(std::string &text) const;
+
+	private:
+		Type m_type;
+
+		bool m_bool;
+
+		double m_number;
+
+		std::string m_string;
+
+		Array m_array;
+
+		Object m_object;
+	};
+}
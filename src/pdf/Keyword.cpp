@@ -6,7 +6,6 @@
  *  License-Identifier: MIT License
  *  See README.md for more information.
  */
-#include <regex>
 #include <iostream>
 #include <podofo/podofo.h>
 
@@ -37,55 +36,77 @@ namespace PDF
 		}
 	};
 
-	KeywordMatcher::KeywordMatcher(string_view term)
+	KeywordMatcher::KeywordMatcher(const Pattern &pattern)
 			: m_isHead(false),
 			  m_hasMatch(false),
+			  m_pattern(&pattern),
 			  m_keyword()
+	{}
+
+	bool KeywordMatcher::FindMatch(PdfTokenizer *tokenizer)
 	{
-		m_term  = term;
-		m_regex = regex(m_term.begin(), m_term.end());
+		Token token{};
+
+		while (tokenizer->GetNextToken(token.data, &token.type))
+		{
+			if (Feed(token))
+			{
+				m_hasMatch = true;
+				break;
+			}
+		}
+		return m_hasMatch;
 	}
 
-	bool KeywordMatcher::FindMatch(PdfTokenizer *tokenizer)
+	bool KeywordMatcher::FindMatches(PdfTokenizer *tokenizer, Keywords &keywords)
 	{
 		Token token{};
 
 		while (tokenizer->GetNextToken(token.data, &token.type))
 		{
-			if (token.type == EPdfTokenType::ePdfTokenType_Delimiter)
+			if (Feed(token))
 			{
-				if (token.IsDelimiter())
-				{
-					if (not m_isHead)
-					{
-						m_isHead = true;
-						continue;
-					}
-					else
-					{
-						m_keyword.clear();
-						m_isHead = false;
-					}
-				}
+				keywords.insert(m_keyword);
+				m_hasMatch = true;
+				// Skip the rest of this keyword's tokens
+				m_keyword.clear();
+				m_isHead = false;
 			}
+		}
+		return m_hasMatch;
+	}
 
-			if (m_isHead)
+	bool KeywordMatcher::Feed(const Token &token)
+	{
+		if (token.type == EPdfTokenType::ePdfTokenType_Delimiter)
+		{
+			if (token.IsDelimiter())
 			{
-				if (m_keyword.empty())
+				if (not m_isHead)
 				{
-					m_keyword = token.data;
+					m_isHead = true;
+					return false;
 				}
 				else
 				{
-					if (regex_search(token.data, m_regex))
-					{
-						m_hasMatch = true;
-						break;
-					}
+					m_keyword.clear();
+					m_isHead = false;
 				}
 			}
 		}
-		return m_hasMatch;
+
+		if (m_isHead)
+		{
+			if (m_keyword.empty())
+			{
+				m_keyword = token.data;
+			}
+			else
+			{
+				return m_pattern->Matches(token.data);
+			}
+		}
+		return false;
 	}
 
 	string_view KeywordMatcher::GetKW() const noexcept
@@ -8,10 +8,11 @@
  */
 #pragma once
 
+#include <set>
 #include <string>
-#include <regex>
 
 #include "Common.hpp"
+#include "Pattern.hpp"
 
 namespace PoDoFo
 {
@@ -20,24 +21,33 @@ namespace PoDoFo
 
 namespace PDF
 {
+	struct Token;
+
 	class KeywordMatcher
 	{
 	public:
-		explicit KeywordMatcher(std::string_view term);
+		using Keywords = std::set<std::string>;
+
+		explicit KeywordMatcher(const Pattern &pattern);
 
 		bool FindMatch(PoDoFo::PdfTokenizer *tokenizer);
 
+		/// Reads the whole token stream collecting every matching keyword
+		bool FindMatches(PoDoFo::PdfTokenizer *tokenizer, Keywords &keywords);
+
 		NODISCARD
 		std::string_view GetKW() const noexcept;
 
+	private:
+		/// Advances the matcher by one token, true if it completes a match
+		bool Feed(const Token &token);
+
 	private:
 		bool m_isHead;
 
 		bool m_hasMatch;
 
-		std::regex m_regex;
-
-		std::string_view m_term;
+		const Pattern *m_pattern;
 
 		std::string m_keyword;
 	};
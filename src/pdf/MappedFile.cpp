@@ -0,0 +1,151 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+#include "MappedFile.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	MappedFile::MappedFile() noexcept
+			: m_data(nullptr),
+			  m_size(0)
+	{}
+
+	MappedFile::MappedFile(const boost::filesystem::path &path)
+			: m_data(nullptr),
+			  m_size(0)
+	{
+		int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (descriptor < 0)
+		{
+			return;
+		}
+
+		struct stat info{};
+		if (::fstat(descriptor, &info) == 0 and info.st_size > 0)
+		{
+			auto size    = static_cast<size_t>(info.st_size);
+			auto address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+			if (address != MAP_FAILED)
+			{
+				// The parser jumps to the trailer first, so ask for the whole file
+				::madvise(address, size, MADV_WILLNEED);
+				m_data = static_cast<const char *>(address);
+				m_size = size;
+			}
+		}
+
+		// The mapping stays valid after the descriptor is closed
+		::close(descriptor);
+	}
+
+	MappedFile::MappedFile(MappedFile &&other) noexcept
+			: m_data(std::exchange(other.m_data, nullptr)),
+			  m_size(std::exchange(other.m_size, 0))
+	{}
+
+	MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			m_data = std::exchange(other.m_data, nullptr);
+			m_size = std::exchange(other.m_size, 0);
+		}
+		return *this;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::IsOpen() const noexcept
+	{
+		return m_data != nullptr;
+	}
+
+	string_view MappedFile::View() const noexcept
+	{
+		return {m_data, m_size};
+	}
+
+	void MappedFile::Close() noexcept
+	{
+		if (m_data)
+		{
+			::munmap(const_cast<char *>(m_data), m_size);
+			m_data = nullptr;
+			m_size = 0;
+		}
+	}
+
+	MemoryStreamBuffer::MemoryStreamBuffer(string_view data)
+	{
+		// The get area is never written through, pbackfail keeps the default
+		auto begin = const_cast<char *>(data.data());
+		setg(begin, begin, begin + data.size());
+	}
+
+	MemoryStreamBuffer::pos_type
+	MemoryStreamBuffer::seekoff(off_type offset, ios_base::seekdir direction, ios_base::openmode which)
+	{
+		if (not (which & ios_base::in))
+		{
+			return pos_type(off_type(-1));
+		}
+
+		off_type base{};
+
+		switch (direction)
+		{
+			case ios_base::beg:
+				base = 0;
+				break;
+			case ios_base::cur:
+				base = gptr() - eback();
+				break;
+			case ios_base::end:
+				base = egptr() - eback();
+				break;
+			default:
+				return pos_type(off_type(-1));
+		}
+
+		off_type position = base + offset;
+
+		if (position < 0 or position > egptr() - eback())
+		{
+			return pos_type(off_type(-1));
+		}
+
+		setg(eback(), eback() + position, egptr());
+		return pos_type(position);
+	}
+
+	MemoryStreamBuffer::pos_type
+	MemoryStreamBuffer::seekpos(pos_type position, ios_base::openmode which)
+	{
+		return seekoff(off_type(position), ios_base::beg, which);
+	}
+
+	MemoryInputStream::MemoryInputStream(string_view data)
+			: std::istream(nullptr),
+			  m_buffer(data)
+	{
+		rdbuf(&m_buffer);
+	}
+}
@@ -0,0 +1,79 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <istream>
+#include <streambuf>
+#include <string_view>
+#include <boost/filesystem.hpp>
+
+#include "Common.hpp"
+
+namespace PDF
+{
+	/**
+	 * Read-only memory mapping of a whole file, released on destruction.
+	 * IsOpen() is false when the file cannot be mapped.
+	 */
+	class MappedFile
+	{
+	public:
+		MappedFile() noexcept;
+
+		explicit MappedFile(const boost::filesystem::path &path);
+
+		MappedFile(const MappedFile &) = delete;
+
+		MappedFile(MappedFile &&other) noexcept;
+
+		MappedFile &operator=(const MappedFile &) = delete;
+
+		MappedFile &operator=(MappedFile &&other) noexcept;
+
+		~MappedFile();
+
+		NODISCARD
+		bool IsOpen() const noexcept;
+
+		NODISCARD
+		std::string_view View() const noexcept;
+
+	private:
+		void Close() noexcept;
+
+	private:
+		const char *m_data;
+
+		size_t m_size;
+	};
+
+	/**
+	 * Seekable read-only stream buffer over memory it does not own,
+	 * lets PoDoFo parse a mapping or a prefetched buffer without copying it.
+	 */
+	class MemoryStreamBuffer : public std::streambuf
+	{
+	public:
+		explicit MemoryStreamBuffer(std::string_view data);
+
+	protected:
+		pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override;
+
+		pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+	};
+
+	class MemoryInputStream : public std::istream
+	{
+	public:
+		explicit MemoryInputStream(std::string_view data);
+
+	private:
+		MemoryStreamBuffer m_buffer;
+	};
+}
@@ -0,0 +1,165 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include "Matcher.hpp"
+#include "DfaMatcher.hpp"
+#include "RegexParser.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	/// Appends the byte of a single-byte node, false for anything else
+	static bool appendLiteral(const RegexNode &node, string &literal)
+	{
+		if (node.type != RegexNode::Type::Bytes or node.bytes.count() != 1)
+		{
+			return false;
+		}
+
+		for (unsigned value{}; value < node.bytes.size(); ++value)
+		{
+			if (node.bytes.test(value))
+			{
+				literal.push_back(static_cast<char>(value));
+				break;
+			}
+		}
+		return true;
+	}
+
+	/// Reads [^]literal patterns, sets anchored when the literal must start the text
+	static bool readLiteral(const RegexNode &root, string &literal, bool &anchored)
+	{
+		anchored = false;
+		literal.clear();
+
+		switch (root.type)
+		{
+			case RegexNode::Type::Empty:
+				return true;
+			case RegexNode::Type::Bytes:
+				return appendLiteral(root, literal);
+			case RegexNode::Type::Concat:
+				break;
+			default:
+				return false;
+		}
+
+		auto child = root.children.begin();
+
+		if ((*child)->type == RegexNode::Type::Begin)
+		{
+			anchored = true;
+			++child;
+		}
+
+		for (; child != root.children.end(); ++child)
+		{
+			if (not appendLiteral(**child, literal))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static void longestRun(const RegexNode &node, string &run, string &longest)
+	{
+		auto finishRun = [&run, &longest]()
+		{
+			if (run.size() > longest.size())
+			{
+				longest = run;
+			}
+			run.clear();
+		};
+
+		switch (node.type)
+		{
+			case RegexNode::Type::Bytes:
+				if (not appendLiteral(node, run))
+				{
+					finishRun();
+				}
+				return;
+			case RegexNode::Type::Concat:
+				// Groups nest concatenations, their literals continue the run
+				for (auto &child : node.children)
+				{
+					longestRun(*child, run, longest);
+				}
+				return;
+			case RegexNode::Type::Repeat:
+			{
+				finishRun();
+				if (node.min > 0)
+				{
+					string inner{};
+					longestRun(*node.children.front(), inner, longest);
+					run = inner;
+				}
+				finishRun();
+				return;
+			}
+			case RegexNode::Type::Empty:
+			case RegexNode::Type::Begin:
+			case RegexNode::Type::End:
+				return;
+			case RegexNode::Type::Alternate:
+				finishRun();
+				return;
+		}
+	}
+
+	Matcher::Ptr Matcher::Create(string_view pattern)
+	{
+		auto   root = RegexParser(pattern).Parse();
+		string literal{};
+		bool   anchored{};
+
+		if (readLiteral(*root, literal, anchored))
+		{
+			if (anchored)
+			{
+				return make_unique<PrefixMatcher>(std::move(literal));
+			}
+			return make_unique<LiteralMatcher>(std::move(literal));
+		}
+
+		return make_unique<DfaMatcher>(*root);
+	}
+
+	string Matcher::RequiredLiteral(string_view pattern)
+	{
+		auto   root = RegexParser(pattern).Parse();
+		string run{}, longest{};
+
+		longestRun(*root, run, longest);
+
+		return run.size() > longest.size() ? run : longest;
+	}
+
+	LiteralMatcher::LiteralMatcher(string literal)
+			: m_literal(std::move(literal))
+	{}
+
+	bool LiteralMatcher::Search(string_view text) const
+	{
+		return text.find(m_literal) != string_view::npos;
+	}
+
+	PrefixMatcher::PrefixMatcher(string prefix)
+			: m_prefix(std::move(prefix))
+	{}
+
+	bool PrefixMatcher::Search(string_view text) const
+	{
+		return text.substr(0, m_prefix.size()) == m_prefix;
+	}
+}
@@ -0,0 +1,71 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "Common.hpp"
+
+namespace PDF
+{
+	/**
+	 * Matching engine behind a Pattern. Search() reports whether
+	 * the pattern occurs anywhere in the text and must be safe to
+	 * call from several threads at once.
+	 */
+	class Matcher
+	{
+	public:
+		using Ptr = std::unique_ptr<const Matcher>;
+
+		virtual ~Matcher() = default;
+
+		NODISCARD
+		virtual bool Search(std::string_view text) const = 0;
+
+		/**
+		 * Picks the cheapest engine for the pattern: a substring search for
+		 * plain literals, a prefix compare for ^literal and the linear-time
+		 * DFA engine otherwise. Throws std::invalid_argument on bad syntax.
+		 */
+		static Ptr Create(std::string_view pattern);
+
+		/**
+		 * Longest byte string every match of the pattern contains,
+		 * empty when there is none.
+		 */
+		static std::string RequiredLiteral(std::string_view pattern);
+	};
+
+	class LiteralMatcher final : public Matcher
+	{
+	public:
+		explicit LiteralMatcher(std::string literal);
+
+		NODISCARD
+		bool Search(std::string_view text) const override;
+
+	private:
+		std::string m_literal;
+	};
+
+	class PrefixMatcher final : public Matcher
+	{
+	public:
+		explicit PrefixMatcher(std::string prefix);
+
+		NODISCARD
+		bool Search(std::string_view text) const override;
+
+	private:
+		std::string m_prefix;
+	};
+}
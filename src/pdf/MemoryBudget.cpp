@@ -0,0 +1,153 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <cctype>
+
+#include "MemoryBudget.hpp"
+#include "Prefilter.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	// PdfMemDocument keeps every parsed object next to the raw bytes, which
+	// measured at three to four times the file size plus a per-page share
+	static constexpr size_t g_bytesPerFileByte{4};
+
+	static constexpr size_t g_bytesPerPage{64 * 1024};
+
+	static constexpr size_t g_baseBytes{1024 * 1024};
+
+	MemoryBudget::Reservation::Reservation() noexcept
+			: m_budget(),
+			  m_bytes()
+	{}
+
+	MemoryBudget::Reservation::Reservation(MemoryBudget *budget, size_t bytes) noexcept
+			: m_budget(budget),
+			  m_bytes(bytes)
+	{}
+
+	MemoryBudget::Reservation::Reservation(Reservation &&other) noexcept
+			: m_budget(other.m_budget),
+			  m_bytes(other.m_bytes)
+	{
+		other.m_budget = nullptr;
+		other.m_bytes  = 0;
+	}
+
+	MemoryBudget::Reservation &
+	MemoryBudget::Reservation::operator=(Reservation &&other) noexcept
+	{
+		if (this != &other)
+		{
+			Release();
+			m_budget       = other.m_budget;
+			m_bytes        = other.m_bytes;
+			other.m_budget = nullptr;
+			other.m_bytes  = 0;
+		}
+		return *this;
+	}
+
+	MemoryBudget::Reservation::~Reservation()
+	{
+		Release();
+	}
+
+	size_t MemoryBudget::Reservation::GetBytes() const noexcept
+	{
+		return m_bytes;
+	}
+
+	void MemoryBudget::Reservation::Release() noexcept
+	{
+		if (m_budget)
+		{
+			m_budget->Release(m_bytes);
+			m_budget = nullptr;
+			m_bytes  = 0;
+		}
+	}
+
+	MemoryBudget::MemoryBudget(size_t limit)
+			: m_limit(limit),
+			  m_used(0),
+			  m_nextTicket(0),
+			  m_serving(0)
+	{}
+
+	MemoryBudget::Reservation MemoryBudget::Acquire(size_t bytes)
+	{
+		unique_lock l(m_mutex);
+		auto        ticket = m_nextTicket++;
+
+		// Serving in arrival order keeps small files from starving a large one
+		m_changed.wait(l, [this, ticket, bytes]
+		{
+			return ticket == m_serving and (m_used == 0 or m_used + bytes <= m_limit);
+		});
+
+		m_used += bytes;
+		++m_serving;
+		l.unlock();
+		m_changed.notify_all();
+
+		return {this, bytes};
+	}
+
+	size_t MemoryBudget::GetLimit() const noexcept
+	{
+		return m_limit;
+	}
+
+	size_t MemoryBudget::Estimate(size_t fileSize, size_t pageCount) noexcept
+	{
+		return g_baseBytes + fileSize * g_bytesPerFileByte + pageCount * g_bytesPerPage;
+	}
+
+	size_t MemoryBudget::CountPages(string_view data) noexcept
+	{
+		static const string_view type{"/Type"};
+		size_t                   pages{};
+		size_t                   position{};
+
+		for (;;)
+		{
+			auto found = Prefilter::Find(data.substr(position), type);
+			if (found == string_view::npos)
+			{
+				break;
+			}
+			position += found + type.size();
+
+			auto rest = data.substr(position);
+			while (not rest.empty() and isspace(static_cast<unsigned char>(rest.front())))
+			{
+				rest.remove_prefix(1);
+			}
+
+			// /Page but not /Pages
+			if (rest.substr(0, 5) == "/Page" and (rest.size() == 5 or rest[5] != 's'))
+			{
+				++pages;
+			}
+		}
+
+		return pages;
+	}
+
+	void MemoryBudget::Release(size_t bytes) noexcept
+	{
+		{
+			lock_guard l(m_mutex);
+			m_used -= bytes;
+		}
+		m_changed.notify_all();
+	}
+}
@@ -0,0 +1,92 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+
+#include "Common.hpp"
+
+namespace PDF
+{
+	/**
+	 * Admits documents in arrival order while their estimated memory fits
+	 * under a limit. A document larger than the whole limit is admitted
+	 * once nothing else is held, so it runs alone. Two documents above
+	 * half the limit never run together.
+	 */
+	class MemoryBudget
+	{
+	public:
+		/// Memory held by one admitted document, given back on destruction
+		class Reservation
+		{
+		public:
+			Reservation() noexcept;
+
+			Reservation(Reservation &&other) noexcept;
+
+			Reservation &operator=(Reservation &&other) noexcept;
+
+			~Reservation();
+
+			NODISCARD
+			size_t GetBytes() const noexcept;
+
+		private:
+			friend class MemoryBudget;
+
+			Reservation(MemoryBudget *budget, size_t bytes) noexcept;
+
+			void Release() noexcept;
+
+		private:
+			MemoryBudget *m_budget;
+
+			size_t m_bytes;
+		};
+
+		explicit MemoryBudget(size_t limit);
+
+		MemoryBudget(const MemoryBudget &) = delete;
+
+		MemoryBudget &operator=(const MemoryBudget &) = delete;
+
+		/// Blocks until the bytes fit and every earlier request was admitted
+		NODISCARD
+		Reservation Acquire(size_t bytes);
+
+		NODISCARD
+		size_t GetLimit() const noexcept;
+
+		/// Peak memory of a parsed document, from its size and page count
+		static size_t Estimate(size_t fileSize, size_t pageCount) noexcept;
+
+		/// Counts /Type /Page objects in the raw bytes, pages inside object streams are missed
+		static size_t CountPages(std::string_view data) noexcept;
+
+	private:
+		void Release(size_t bytes) noexcept;
+
+	private:
+		size_t m_limit;
+
+		size_t m_used;
+
+		uint64_t m_nextTicket;
+
+		uint64_t m_serving;
+
+		std::mutex m_mutex;
+
+		std::condition_variable m_changed;
+	};
+}
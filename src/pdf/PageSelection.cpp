@@ -0,0 +1,194 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "PageSelection.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	static string_view trim(string_view text) noexcept
+	{
+		while (not text.empty() and text.front() == ' ')
+		{
+			text.remove_prefix(1);
+		}
+		while (not text.empty() and text.back() == ' ')
+		{
+			text.remove_suffix(1);
+		}
+		return text;
+	}
+
+	/// Page number of text, zero when it is not a positive number
+	static int parsePage(string_view text) noexcept
+	{
+		int page{};
+
+		if (text.empty() or text.size() > 9)
+		{
+			return 0;
+		}
+
+		for (char c : text)
+		{
+			if (c < '0' or c > '9')
+			{
+				return 0;
+			}
+			page = page * 10 + (c - '0');
+		}
+
+		return page;
+	}
+
+	PageSelection::PageSelection(string_view list)
+			: m_ranges()
+	{
+		auto invalid = [&list]()
+		{
+			return invalid_argument("Invalid page selection \'" + string(list) + '\'');
+		};
+
+		for (size_t begin{}; begin <= list.size();)
+		{
+			auto end  = min(list.find(',', begin), list.size());
+			auto item = trim(list.substr(begin, end - begin));
+			auto dash = item.find('-');
+
+			begin = end + 1;
+
+			if (dash == string_view::npos)
+			{
+				int page = parsePage(item);
+				if (not page)
+				{
+					throw invalid();
+				}
+				m_ranges.push_back({page, page, false});
+			}
+			else if (dash == 0)
+			{
+				int count = parsePage(trim(item.substr(1)));
+				if (not count)
+				{
+					throw invalid();
+				}
+				m_ranges.push_back({count, 0, true});
+			}
+			else
+			{
+				int  first    = parsePage(trim(item.substr(0, dash)));
+				auto lastText = trim(item.substr(dash + 1));
+				int  last     = lastText.empty() ? 0 : parsePage(lastText);
+
+				if (not first or (not lastText.empty() and (not last or last < first)))
+				{
+					throw invalid();
+				}
+				m_ranges.push_back({first, last, false});
+			}
+		}
+	}
+
+	PageSelection PageSelection::From(int pageIndex)
+	{
+		PageSelection selection{};
+
+		if (pageIndex > 0)
+		{
+			selection.m_ranges.push_back({pageIndex + 1, 0, false});
+			selection.m_fromIndex = true;
+		}
+		return selection;
+	}
+
+	vector<int> PageSelection::Resolve(int pageCount) const
+	{
+		vector<int> pages{};
+
+		if (pageCount <= 0)
+		{
+			return pages;
+		}
+
+		if (m_ranges.empty() or (m_fromIndex and m_ranges.front().first - 1 > pageCount))
+		{
+			pages.resize(static_cast<size_t>(pageCount));
+			for (int index{}; index < pageCount; ++index)
+			{
+				pages[static_cast<size_t>(index)] = index;
+			}
+			return pages;
+		}
+
+		vector<bool> selected(static_cast<size_t>(pageCount));
+
+		for (const auto &range : m_ranges)
+		{
+			int first = range.fromEnd ? max(pageCount - range.first + 1, 1) : range.first;
+			int last  = range.fromEnd or not range.last ? pageCount : min(range.last, pageCount);
+
+			for (int page = first; page <= last; ++page)
+			{
+				selected[static_cast<size_t>(page - 1)] = true;
+			}
+		}
+
+		for (int index{}; index < pageCount; ++index)
+		{
+			if (selected[static_cast<size_t>(index)])
+			{
+				pages.push_back(index);
+			}
+		}
+
+		return pages;
+	}
+
+	bool PageSelection::IsAll() const noexcept
+	{
+		return m_ranges.empty();
+	}
+
+	string PageSelection::ToString() const
+	{
+		string list{};
+
+		for (const auto &range : m_ranges)
+		{
+			if (not list.empty())
+			{
+				list.push_back(',');
+			}
+
+			if (range.fromEnd)
+			{
+				list.append("-").append(to_string(range.first));
+			}
+			else if (range.first == range.last)
+			{
+				list.append(to_string(range.first));
+			}
+			else
+			{
+				list.append(to_string(range.first)).append("-");
+				if (range.last)
+				{
+					list.append(to_string(range.last));
+				}
+			}
+		}
+
+		return list;
+	}
+}
@@ -0,0 +1,67 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Common.hpp"
+
+namespace PDF
+{
+	/**
+	 * Pages given as a list such as "1-3,10,-5": single pages, ranges,
+	 * "N-" for page N to the last one and "-N" for the last N pages.
+	 * Pages are numbered from 1; an empty selection is every page.
+	 */
+	class PageSelection
+	{
+	public:
+		PageSelection() = default;
+
+		/// Throws std::invalid_argument on a malformed list
+		explicit PageSelection(std::string_view list);
+
+		/**
+		 * Every page from the zero-based pageIndex on. Every page when it is
+		 * negative or past the page count of the document, as --number
+		 * always did; starting exactly at the page count selects nothing.
+		 */
+		static PageSelection From(int pageIndex);
+
+		/// Zero-based indices of the selected pages that exist, ascending and unique
+		NODISCARD
+		std::vector<int> Resolve(int pageCount) const;
+
+		NODISCARD
+		bool IsAll() const noexcept;
+
+		/// The selection as a list in the form parsed, empty for every page
+		NODISCARD
+		std::string ToString() const;
+
+	private:
+		struct Range
+		{
+			int first;
+
+			/// Zero for a range running to the last page
+			int last;
+
+			/// The last first pages, last is unused
+			bool fromEnd;
+		};
+
+		std::vector<Range> m_ranges;
+
+		/// Made by From(), falls back to every page past the end
+		bool m_fromIndex{};
+	};
+}
@@ -0,0 +1,107 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include "Pattern.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	static string alternation(const vector<string> &sources)
+	{
+		string result{};
+
+		for (const auto &source : sources)
+		{
+			if (source.empty())
+			{
+				continue;
+			}
+
+			if (not result.empty())
+			{
+				result.append("|");
+			}
+			result.append("(?:").append(source).append(")");
+		}
+
+		return result;
+	}
+
+	Pattern::Pattern(string_view source)
+			: m_source(source),
+			  m_literal(Matcher::RequiredLiteral(source)),
+			  m_matcher(Matcher::Create(source))
+	{}
+
+	Pattern::Pattern(string_view source, Matcher::Ptr matcher)
+			: m_source(source),
+			  m_literal(Matcher::RequiredLiteral(source)),
+			  m_matcher(std::move(matcher))
+	{}
+
+	bool Pattern::Matches(string_view text) const
+	{
+		return m_matcher->Search(text);
+	}
+
+	string_view Pattern::GetSource() const noexcept
+	{
+		return m_source;
+	}
+
+	string_view Pattern::GetRequiredLiteral() const noexcept
+	{
+		return m_literal;
+	}
+
+	PatternSet::PatternSet(const vector<string> &sources)
+			: m_patterns(),
+			  m_combined(alternation(sources))
+	{
+		m_patterns.reserve(sources.size());
+
+		for (const auto &source : sources)
+		{
+			if (not source.empty())
+			{
+				m_patterns.emplace_back(source);
+			}
+		}
+	}
+
+	const Pattern &PatternSet::At(size_t index) const
+	{
+		return m_patterns.at(index);
+	}
+
+	const Pattern &PatternSet::GetCombined() const noexcept
+	{
+		return m_combined;
+	}
+
+	size_t PatternSet::GetSize() const noexcept
+	{
+		return m_patterns.size();
+	}
+
+	bool PatternSet::Empty() const noexcept
+	{
+		return m_patterns.empty();
+	}
+
+	PatternSet::ConstIterator PatternSet::begin() const noexcept
+	{
+		return m_patterns.begin();
+	}
+
+	PatternSet::ConstIterator PatternSet::end() const noexcept
+	{
+		return m_patterns.end();
+	}
+}
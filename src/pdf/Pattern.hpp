@@ -0,0 +1,92 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Common.hpp"
+#include "Matcher.hpp"
+
+namespace PDF
+{
+	/**
+	 * Uri search pattern compiled once. Matching does not mutate
+	 * the pattern, so one instance may be shared between threads.
+	 */
+	class Pattern
+	{
+	public:
+		explicit Pattern(std::string_view source);
+
+		/// Uses the given engine instead of the one Matcher::Create picks
+		Pattern(std::string_view source, Matcher::Ptr matcher);
+
+		NODISCARD
+		bool Matches(std::string_view text) const;
+
+		NODISCARD
+		std::string_view GetSource() const noexcept;
+
+		/// Bytes present in every match, empty if the pattern has none
+		NODISCARD
+		std::string_view GetRequiredLiteral() const noexcept;
+
+	private:
+		std::string m_source;
+
+		std::string m_literal;
+
+		Matcher::Ptr m_matcher;
+	};
+
+	/**
+	 * Immutable set of patterns built from the command line uris.
+	 * The combined pattern matches when any of the patterns matches,
+	 * so a document can be searched for the whole set in one pass.
+	 */
+	class PatternSet
+	{
+	public:
+		using Patterns = std::vector<Pattern>;
+
+		using ConstIterator = Patterns::const_iterator;
+
+		PatternSet() = default;
+
+		explicit PatternSet(const std::vector<std::string> &sources);
+
+		NODISCARD
+		const Pattern &At(size_t index) const;
+
+		NODISCARD
+		const Pattern &GetCombined() const noexcept;
+
+		NODISCARD
+		size_t GetSize() const noexcept;
+
+		NODISCARD
+		bool Empty() const noexcept;
+
+		NODISCARD
+		ConstIterator begin() const noexcept;
+
+		NODISCARD
+		ConstIterator end() const noexcept;
+
+	private:
+		Patterns m_patterns;
+
+		Pattern m_combined{std::string_view{}};
+	};
+
+	using PatternSetPtr = std::shared_ptr<const PatternSet>;
+}
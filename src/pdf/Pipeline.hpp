@@ -0,0 +1,143 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.hpp"
+#include "Common.hpp"
+#include "Trace.hpp"
+
+namespace PDF
+{
+	/**
+	 * Chain of stages, each run by its own threads, passing jobs along
+	 * bounded queues so a slow stage holds back the ones before it.
+	 * A stage returning false, or throwing, finishes the job early.
+	 */
+	template<typename Job>
+	class Pipeline
+	{
+	public:
+		using Source = std::function<bool(Job &)>;
+		using Stage = std::function<bool(Job &)>;
+		using ErrorHandler = std::function<void(Job &, std::exception_ptr)>;
+
+		explicit Pipeline(size_t capacity)
+				: m_capacity(capacity),
+				  m_stages(),
+				  m_onError()
+		{}
+
+		/// The stage name labels its threads in a trace
+		Pipeline &AddStage(const char *name, size_t threadCount, Stage stage)
+		{
+			m_stages.push_back({name, threadCount ? threadCount : 1, std::move(stage)});
+			return *this;
+		}
+
+		Pipeline &OnError(ErrorHandler handler)
+		{
+			m_onError = std::move(handler);
+			return *this;
+		}
+
+		/// Feeds the jobs of source through every stage, blocks until all are done
+		void Run(Source source)
+		{
+			const size_t                                    count = m_stages.size();
+			std::vector<std::unique_ptr<BoundedQueue<Job>>> queues;
+			std::vector<std::atomic<size_t>>                running(count);
+			std::vector<std::thread>                        threads;
+
+			for (size_t i{}; i + 1 < count; ++i)
+			{
+				queues.push_back(std::make_unique<BoundedQueue<Job>>(m_capacity));
+			}
+
+			for (size_t i{}; i < count; ++i)
+			{
+				running[i] = m_stages[i].threadCount;
+				Source pull = i ? Source([queue = queues[i - 1].get()](Job &job) { return queue->Pop(job); })
+				                : source;
+				BoundedQueue<Job> *next = i + 1 < count ? queues[i].get() : nullptr;
+
+				for (size_t t{}; t < m_stages[i].threadCount; ++t)
+				{
+					threads.emplace_back([this, i, pull, next, &running]
+					{
+						Trace::SetThreadName(m_stages[i].name);
+						Work(m_stages[i].stage, pull, next);
+
+						// The last thread of a stage lets the next one drain and stop
+						if (--running[i] == 0 and next)
+						{
+							next->Close();
+						}
+					});
+				}
+			}
+
+			for (auto &thread : threads)
+			{
+				thread.join();
+			}
+		}
+
+	private:
+		struct StageInfo
+		{
+			const char *name;
+
+			size_t threadCount;
+
+			Stage stage;
+		};
+
+		void Work(const Stage &stage, const Source &pull, BoundedQueue<Job> *next)
+		{
+			Job job{};
+
+			while (pull(job))
+			{
+				bool forward{};
+
+				try
+				{
+					forward = stage(job);
+				}
+				catch (...)
+				{
+					if (m_onError)
+					{
+						m_onError(job, std::current_exception());
+					}
+				}
+
+				if (forward and next)
+				{
+					next->Push(std::move(job));
+				}
+				job = Job{};
+			}
+		}
+
+	private:
+		size_t m_capacity;
+
+		std::vector<StageInfo> m_stages;
+
+		ErrorHandler m_onError;
+	};
+}
@@ -0,0 +1,197 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "MappedFile.hpp"
+#include "Prefilter.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	static const string_view g_objectStreamMarker{"/ObjStm"};
+
+	static const string_view g_uriKey{"/URI"};
+
+	static bool isWhitespace(char c)
+	{
+		return c == ' ' or c == '\n' or c == '\r' or c == '\t' or c == '\f' or c == '\0';
+	}
+
+	/**
+	 * Whether some /URI value is not written as plain bytes, so that a
+	 * literal search cannot see it: a hex string, a reference to the string,
+	 * or a literal string with escapes or in UTF-16BE.
+	 */
+	static bool hasEncodedUri(string_view data)
+	{
+		for (size_t index = Prefilter::Find(data, g_uriKey); index != string_view::npos;)
+		{
+			size_t position = index + g_uriKey.size();
+
+			while (position < data.size() and isWhitespace(data[position]))
+			{
+				++position;
+			}
+
+			if (position < data.size())
+			{
+				const char c = data[position];
+
+				if (c == '<' or (c >= '0' and c <= '9'))
+				{
+					return true;
+				}
+
+				if (c == '(')
+				{
+					auto value = data.substr(position + 1);
+
+					if (value.substr(0, 2) == "\xFE\xFF")
+					{
+						return true;
+					}
+
+					// Balanced parentheses may appear unescaped, the first escape settles it
+					for (size_t i{}, depth{1}; i < value.size() and depth; ++i)
+					{
+						switch (value[i])
+						{
+							case '\\':
+								return true;
+							case '(':
+								++depth;
+								break;
+							case ')':
+								--depth;
+								break;
+							default:
+								break;
+						}
+					}
+				}
+			}
+
+			auto next = Prefilter::Find(data.substr(position), g_uriKey);
+			index = next == string_view::npos ? next : position + next;
+		}
+		return false;
+	}
+
+	Prefilter::Prefilter(const PatternSet &patterns)
+			: m_enabled(not patterns.Empty()),
+			  m_literals()
+	{
+		for (const auto &pattern : patterns)
+		{
+			if (pattern.GetRequiredLiteral().empty())
+			{
+				m_enabled = false;
+				m_literals.clear();
+				break;
+			}
+			m_literals.emplace_back(pattern.GetRequiredLiteral());
+		}
+	}
+
+	bool Prefilter::IsEnabled() const noexcept
+	{
+		return m_enabled;
+	}
+
+	bool Prefilter::IsCandidate(string_view data) const
+	{
+		if (not m_enabled)
+		{
+			return true;
+		}
+
+		for (const auto &literal : m_literals)
+		{
+			if (Find(data, literal) != string_view::npos)
+			{
+				return true;
+			}
+		}
+
+		return Find(data, g_objectStreamMarker) != string_view::npos or hasEncodedUri(data);
+	}
+
+	bool Prefilter::IsCandidate(const boost::filesystem::path &path) const
+	{
+		if (not m_enabled)
+		{
+			return true;
+		}
+
+		MappedFile file(path);
+		return not file.IsOpen() or IsCandidate(file.View());
+	}
+
+	size_t Prefilter::Find(string_view haystack, string_view needle) noexcept
+	{
+		const size_t length = needle.size();
+
+		if (length < 2 or haystack.size() < length)
+		{
+			return haystack.find(needle);
+		}
+
+		const char *data = haystack.data();
+		size_t     index{};
+
+		// Compares the first and last needle byte at every offset of a block
+		// at once, only offsets where both agree are checked with memcmp
+#if defined(__AVX2__)
+		constexpr size_t blockSize = 32;
+		const __m256i    first     = _mm256_set1_epi8(needle.front());
+		const __m256i    last      = _mm256_set1_epi8(needle.back());
+
+		for (; index + length - 1 + blockSize <= haystack.size(); index += blockSize)
+		{
+			auto blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + index));
+			auto blockLast  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + index + length - 1));
+			auto mask       = static_cast<uint32_t>(_mm256_movemask_epi8(
+					_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last))));
+#elif defined(__SSE2__)
+		constexpr size_t blockSize = 16;
+		const __m128i    first     = _mm_set1_epi8(needle.front());
+		const __m128i    last      = _mm_set1_epi8(needle.back());
+
+		for (; index + length - 1 + blockSize <= haystack.size(); index += blockSize)
+		{
+			auto blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + index));
+			auto blockLast  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + index + length - 1));
+			auto mask       = static_cast<uint32_t>(_mm_movemask_epi8(
+					_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last))));
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+			while (mask)
+			{
+				auto offset = static_cast<size_t>(__builtin_ctz(mask));
+
+				if (memcmp(data + index + offset + 1, needle.data() + 1, length - 2) == 0)
+				{
+					return index + offset;
+				}
+				mask &= mask - 1;
+			}
+		}
+#endif
+
+		auto tail = haystack.substr(index).find(needle);
+		return tail == string_view::npos ? tail : index + tail;
+	}
+}
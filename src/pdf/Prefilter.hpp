@@ -0,0 +1,52 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "Common.hpp"
+#include "Pattern.hpp"
+
+namespace PDF
+{
+	/**
+	 * Rejects files before parsing by searching their raw bytes for the
+	 * literal every match of a pattern must contain. Files with compressed
+	 * object streams stay candidates, as the literal may be hidden there,
+	 * and so do files with a /URI written as a hex string, with escapes, in
+	 * UTF-16BE or in another object. Disabled when some pattern has no
+	 * literal to look for.
+	 */
+	class Prefilter
+	{
+	public:
+		explicit Prefilter(const PatternSet &patterns);
+
+		NODISCARD
+		bool IsEnabled() const noexcept;
+
+		NODISCARD
+		bool IsCandidate(std::string_view data) const;
+
+		/// Files that cannot be mapped are left to the parser to report
+		NODISCARD
+		bool IsCandidate(const boost::filesystem::path &path) const;
+
+		/// Vectorized substring search, returns npos when absent
+		static size_t Find(std::string_view haystack, std::string_view needle) noexcept;
+
+	private:
+		bool m_enabled;
+
+		std::vector<std::string> m_literals;
+	};
+}
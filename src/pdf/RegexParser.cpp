@@ -0,0 +1,512 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <stdexcept>
+
+#include "RegexParser.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	using ByteSet = RegexNode::ByteSet;
+
+	static ByteSet byteRange(unsigned char first, unsigned char last)
+	{
+		ByteSet set{};
+		for (unsigned value = first; value <= last; ++value)
+		{
+			set.set(value);
+		}
+		return set;
+	}
+
+	static ByteSet singleByte(char c)
+	{
+		ByteSet set{};
+		set.set(static_cast<unsigned char>(c));
+		return set;
+	}
+
+	static ByteSet digitBytes()
+	{
+		return byteRange('0', '9');
+	}
+
+	static ByteSet wordBytes()
+	{
+		return byteRange('a', 'z') | byteRange('A', 'Z') | digitBytes() | singleByte('_');
+	}
+
+	static ByteSet spaceBytes()
+	{
+		return byteRange('\t', '\r') | singleByte(' ');
+	}
+
+	static int hexValue(char c)
+	{
+		if (c >= '0' and c <= '9')
+		{
+			return c - '0';
+		}
+		if (c >= 'a' and c <= 'f')
+		{
+			return c - 'a' + 10;
+		}
+		if (c >= 'A' and c <= 'F')
+		{
+			return c - 'A' + 10;
+		}
+		return -1;
+	}
+
+	RegexNode::RegexNode(Type aType)
+			: type(aType),
+			  bytes(),
+			  children(),
+			  min(1),
+			  max(1)
+	{}
+
+	RegexNode::RegexNode(Type aType, const ByteSet &aBytes)
+			: type(aType),
+			  bytes(aBytes),
+			  children(),
+			  min(1),
+			  max(1)
+	{}
+
+	RegexParser::RegexParser(string_view pattern)
+			: m_pattern(pattern),
+			  m_pos(0)
+	{}
+
+	RegexParser::NodePtr RegexParser::Parse()
+	{
+		m_pos     = 0;
+		auto root = ParseAlternation();
+
+		if (not AtEnd())
+		{
+			Fail("unmatched ')'");
+		}
+
+		if (ProgramSize(*root) > MaxProgramSize)
+		{
+			Fail("pattern is too large");
+		}
+
+		return root;
+	}
+
+	size_t RegexParser::ProgramSize(const RegexNode &node) noexcept
+	{
+		constexpr size_t limit = MaxProgramSize + 1;
+		size_t           size{};
+
+		switch (node.type)
+		{
+			case RegexNode::Type::Empty:
+				return 0;
+			case RegexNode::Type::Bytes:
+			case RegexNode::Type::Begin:
+			case RegexNode::Type::End:
+				return 1;
+			case RegexNode::Type::Concat:
+			case RegexNode::Type::Alternate:
+				// An alternation adds one split state
+				size = node.type == RegexNode::Type::Alternate ? 1 : 0;
+				for (const auto &child : node.children)
+				{
+					size = min(size + ProgramSize(*child), limit);
+				}
+				return size;
+			case RegexNode::Type::Repeat:
+			{
+				// The body is copied once per mandatory and once per optional repetition
+				auto body   = ProgramSize(*node.children.front());
+				auto copies = static_cast<size_t>(node.max == RegexNode::Unbounded ? node.min + 1 : node.max);
+				auto splits = static_cast<size_t>(node.max == RegexNode::Unbounded ? 1 : node.max - node.min);
+
+				if (body and copies > limit / body)
+				{
+					return limit;
+				}
+				return min(body * copies + splits, limit);
+			}
+		}
+		return size;
+	}
+
+	RegexParser::NodePtr RegexParser::ParseAlternation()
+	{
+		auto first = ParseConcat();
+
+		if (AtEnd() or Peek() != '|')
+		{
+			return first;
+		}
+
+		auto alternation = make_unique<RegexNode>(RegexNode::Type::Alternate);
+		alternation->children.push_back(std::move(first));
+
+		while (not AtEnd() and Peek() == '|')
+		{
+			Next();
+			alternation->children.push_back(ParseConcat());
+		}
+
+		return alternation;
+	}
+
+	RegexParser::NodePtr RegexParser::ParseConcat()
+	{
+		auto concat = make_unique<RegexNode>(RegexNode::Type::Concat);
+
+		while (not AtEnd() and Peek() != '|' and Peek() != ')')
+		{
+			concat->children.push_back(ParseRepeat());
+		}
+
+		if (concat->children.empty())
+		{
+			return make_unique<RegexNode>(RegexNode::Type::Empty);
+		}
+
+		if (concat->children.size() == 1)
+		{
+			return std::move(concat->children.front());
+		}
+
+		return concat;
+	}
+
+	RegexParser::NodePtr RegexParser::ParseRepeat()
+	{
+		auto atom = ParseAtom();
+
+		while (not AtEnd())
+		{
+			int  min{}, max{};
+			auto start = m_pos;
+
+			switch (Peek())
+			{
+				case '*':
+					Next();
+					min = 0;
+					max = RegexNode::Unbounded;
+					break;
+				case '+':
+					Next();
+					min = 1;
+					max = RegexNode::Unbounded;
+					break;
+				case '?':
+					Next();
+					min = 0;
+					max = 1;
+					break;
+				case '{':
+					if (not ParseBounds(min, max))
+					{
+						// Not a quantifier, '{' is read as a literal
+						m_pos = start;
+						return atom;
+					}
+					break;
+				default:
+					return atom;
+			}
+
+			// Laziness does not change whether the text matches
+			if (not AtEnd() and Peek() == '?')
+			{
+				Next();
+			}
+
+			auto repeat = make_unique<RegexNode>(RegexNode::Type::Repeat);
+			repeat->min = min;
+			repeat->max = max;
+			repeat->children.push_back(std::move(atom));
+			atom = std::move(repeat);
+		}
+
+		return atom;
+	}
+
+	RegexParser::NodePtr RegexParser::ParseAtom()
+	{
+		char c = Next();
+
+		switch (c)
+		{
+			case '(':
+			{
+				if (not AtEnd() and Peek() == '?')
+				{
+					Next();
+					if (AtEnd() or Next() != ':')
+					{
+						Fail("lookaround groups are not supported");
+					}
+				}
+
+				auto group = ParseAlternation();
+
+				if (AtEnd() or Next() != ')')
+				{
+					Fail("missing ')'");
+				}
+				return group;
+			}
+			case '[':
+				return make_unique<RegexNode>(RegexNode::Type::Bytes, ParseClass());
+			case '.':
+				return make_unique<RegexNode>(RegexNode::Type::Bytes,
+				                              ~(singleByte('\n') | singleByte('\r')));
+			case '^':
+				return make_unique<RegexNode>(RegexNode::Type::Begin);
+			case '$':
+				return make_unique<RegexNode>(RegexNode::Type::End);
+			case '\\':
+				return make_unique<RegexNode>(RegexNode::Type::Bytes, ParseEscape(false));
+			case '*':
+			case '+':
+			case '?':
+				Fail("nothing to repeat");
+			default:
+				return make_unique<RegexNode>(RegexNode::Type::Bytes, singleByte(c));
+		}
+	}
+
+	ByteSet RegexParser::ParseClass()
+	{
+		ByteSet set{};
+		bool    negate{};
+
+		if (not AtEnd() and Peek() == '^')
+		{
+			Next();
+			negate = true;
+		}
+
+		for (;;)
+		{
+			if (AtEnd())
+			{
+				Fail("missing ']'");
+			}
+
+			char c = Next();
+
+			// As in ECMAScript, [] matches nothing and [^] matches any byte
+			if (c == ']')
+			{
+				break;
+			}
+
+			ByteSet item = (c == '\\') ? ParseEscape(true) : singleByte(c);
+
+			// Range such as a-z, a trailing '-' is a literal
+			if (item.count() == 1 and m_pos + 1 < m_pattern.size()
+			    and Peek() == '-' and m_pattern[m_pos + 1] != ']')
+			{
+				Next();
+				char      last     = Next();
+				ByteSet   lastItem = (last == '\\') ? ParseEscape(true) : singleByte(last);
+				unsigned  from{}, to{};
+
+				if (lastItem.count() != 1)
+				{
+					Fail("invalid class range");
+				}
+
+				while (not item.test(from))
+				{
+					++from;
+				}
+				while (not lastItem.test(to))
+				{
+					++to;
+				}
+				if (from > to)
+				{
+					Fail("invalid class range");
+				}
+
+				item = byteRange(static_cast<unsigned char>(from), static_cast<unsigned char>(to));
+			}
+
+			set |= item;
+		}
+
+		return negate ? ~set : set;
+	}
+
+	ByteSet RegexParser::ParseEscape(bool inClass)
+	{
+		if (AtEnd())
+		{
+			Fail("trailing '\\'");
+		}
+
+		char c = Next();
+
+		switch (c)
+		{
+			case 'd':
+				return digitBytes();
+			case 'D':
+				return ~digitBytes();
+			case 'w':
+				return wordBytes();
+			case 'W':
+				return ~wordBytes();
+			case 's':
+				return spaceBytes();
+			case 'S':
+				return ~spaceBytes();
+			case 't':
+				return singleByte('\t');
+			case 'n':
+				return singleByte('\n');
+			case 'r':
+				return singleByte('\r');
+			case 'f':
+				return singleByte('\f');
+			case 'v':
+				return singleByte('\v');
+			case '0':
+				return singleByte('\0');
+			case 'b':
+				if (inClass)
+				{
+					return singleByte('\b');
+				}
+				Fail("word boundaries are not supported");
+			case 'B':
+				Fail("word boundaries are not supported");
+			case 'x':
+			{
+				int high = AtEnd() ? -1 : hexValue(Next());
+				int low  = AtEnd() ? -1 : hexValue(Next());
+
+				if (high < 0 or low < 0)
+				{
+					Fail("invalid \\x escape");
+				}
+				return singleByte(static_cast<char>(high * 16 + low));
+			}
+			case 'u':
+			{
+				int value{};
+
+				for (int i{}; i < 4; ++i)
+				{
+					int digit = AtEnd() ? -1 : hexValue(Next());
+					if (digit < 0)
+					{
+						Fail("invalid \\u escape");
+					}
+					value = value * 16 + digit;
+				}
+
+				if (value > 0x7f)
+				{
+					Fail("non-ASCII \\u escapes are not supported");
+				}
+				return singleByte(static_cast<char>(value));
+			}
+			default:
+				if (c >= '1' and c <= '9')
+				{
+					Fail("backreferences are not supported");
+				}
+				return singleByte(c);
+		}
+	}
+
+	bool RegexParser::ParseBounds(int &min, int &max)
+	{
+		Next(); // '{'
+
+		if (not ParseNumber(min))
+		{
+			return false;
+		}
+
+		max = min;
+
+		if (not AtEnd() and Peek() == ',')
+		{
+			Next();
+			max = RegexNode::Unbounded;
+
+			if (not AtEnd() and Peek() != '}' and not ParseNumber(max))
+			{
+				return false;
+			}
+		}
+
+		if (AtEnd() or Next() != '}')
+		{
+			return false;
+		}
+
+		if (max != RegexNode::Unbounded and max < min)
+		{
+			Fail("invalid repeat bounds");
+		}
+
+		if (min > MaxRepeat or max > MaxRepeat)
+		{
+			Fail("repeat count is too large");
+		}
+
+		return true;
+	}
+
+	bool RegexParser::ParseNumber(int &value)
+	{
+		auto start = m_pos;
+		value = 0;
+
+		while (not AtEnd() and Peek() >= '0' and Peek() <= '9')
+		{
+			value = min(value * 10 + (Next() - '0'), MaxRepeat + 1);
+		}
+
+		return m_pos != start;
+	}
+
+	bool RegexParser::AtEnd() const noexcept
+	{
+		return m_pos >= m_pattern.size();
+	}
+
+	char RegexParser::Peek() const noexcept
+	{
+		return m_pattern[m_pos];
+	}
+
+	char RegexParser::Next() noexcept
+	{
+		return m_pattern[m_pos++];
+	}
+
+	void RegexParser::Fail(string_view reason) const
+	{
+		string message("Invalid pattern '");
+		message.append(m_pattern)
+		       .append("': ")
+		       .append(reason);
+
+		throw invalid_argument(message);
+	}
+}
@@ -0,0 +1,115 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <bitset>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Common.hpp"
+
+namespace PDF
+{
+	/**
+	 * Syntax tree of a regular expression over bytes.
+	 */
+	struct RegexNode
+	{
+		enum class Type
+		{
+			Empty,     // Matches the empty string
+			Bytes,     // One byte out of a set
+			Concat,    // Children in sequence
+			Alternate, // Any one of the children
+			Repeat,    // Child repeated [min, max] times
+			Begin,     // Start of the text
+			End        // End of the text
+		};
+
+		using ByteSet = std::bitset<256>;
+
+		using Children = std::vector<std::unique_ptr<RegexNode>>;
+
+		static constexpr int Unbounded = -1;
+
+		Type type;
+
+		ByteSet bytes;
+
+		Children children;
+
+		int min;
+
+		int max;
+
+		explicit RegexNode(Type aType);
+
+		RegexNode(Type aType, const ByteSet &aBytes);
+	};
+
+	/**
+	 * Parses the ECMAScript subset that can be matched in linear time:
+	 * literals, classes, escapes, groups, alternation, greedy and lazy
+	 * quantifiers and the ^ / $ anchors. Backreferences, lookarounds and
+	 * word boundaries are rejected with std::invalid_argument.
+	 */
+	class RegexParser
+	{
+	public:
+		using NodePtr = std::unique_ptr<RegexNode>;
+
+		static constexpr int MaxRepeat = 1000;
+
+		/// NFA states one pattern may compile to, nested repeats multiply their bodies
+		static constexpr size_t MaxProgramSize = 20000;
+
+		/// States Compile() of the DFA engine makes for the tree, saturated past MaxProgramSize
+		static size_t ProgramSize(const RegexNode &node) noexcept;
+
+		explicit RegexParser(std::string_view pattern);
+
+		NODISCARD
+		NodePtr Parse();
+
+	private:
+		NodePtr ParseAlternation();
+
+		NodePtr ParseConcat();
+
+		NodePtr ParseRepeat();
+
+		NodePtr ParseAtom();
+
+		RegexNode::ByteSet ParseClass();
+
+		RegexNode::ByteSet ParseEscape(bool inClass);
+
+		bool ParseBounds(int &min, int &max);
+
+		bool ParseNumber(int &value);
+
+		NODISCARD
+		bool AtEnd() const noexcept;
+
+		NODISCARD
+		char Peek() const noexcept;
+
+		char Next() noexcept;
+
+		[[noreturn]]
+		void Fail(std::string_view reason) const;
+
+	private:
+		std::string_view m_pattern;
+
+		size_t m_pos;
+	};
+}
@@ -0,0 +1,307 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <chrono>
+#include <stdexcept>
+#include <boost/filesystem/fstream.hpp>
+
+#include "MappedFile.hpp"
+#include "SanitizeSession.hpp"
+#include "Trace.hpp"
+
+using namespace std;
+using namespace PoDoFo;
+
+namespace PDF
+{
+	using Clock = chrono::steady_clock;
+
+	static double secondsSince(Clock::time_point &start)
+	{
+		auto now     = Clock::now();
+		auto elapsed = chrono::duration<double>(now - start).count();
+		start = now;
+		return elapsed;
+	}
+
+	SanitizeSession::SanitizeSession(SessionOptions options)
+			: m_options(std::move(options)),
+			  m_patterns(make_shared<const PatternSet>(m_options.uris)),
+			  m_prefilter(),
+			  m_budget(),
+			  m_pool(m_options.jobs)
+	{
+		if (m_options.prefilter)
+		{
+			m_prefilter = make_unique<Prefilter>(*m_patterns);
+		}
+
+		if (m_options.maxMemory)
+		{
+			m_budget = make_unique<MemoryBudget>(m_options.maxMemory);
+		}
+	}
+
+	SanitizeSession::~SanitizeSession()
+	{
+		m_pool.Wait();
+	}
+
+	future<SanitizeResult> SanitizeSession::Submit(SanitizeRequest request)
+	{
+		auto promise = make_shared<std::promise<SanitizeResult>>();
+		auto result  = promise->get_future();
+
+		Submit(std::move(request), [promise](SanitizeResult value)
+		{
+			promise->set_value(std::move(value));
+		});
+		return result;
+	}
+
+	void SanitizeSession::Submit(SanitizeRequest request, Callback callback)
+	{
+		// Tasks have to be copyable, so the request is shared with the task
+		auto shared = make_shared<SanitizeRequest>(std::move(request));
+
+		m_pool.Submit([this, shared, callback = std::move(callback)]
+		{
+			callback(Run(*shared));
+		});
+	}
+
+	future<SanitizeResult> SanitizeSession::Submit(Path input)
+	{
+		return Submit(SanitizeRequest{std::move(input), {}, {}, {}, {}});
+	}
+
+	future<SanitizeResult> SanitizeSession::Submit(Path input, Path output)
+	{
+		return Submit(SanitizeRequest{std::move(input), std::move(output), {}, {}, {}});
+	}
+
+	future<SanitizeResult> SanitizeSession::Submit(string contents, DocumentProperty properties)
+	{
+		return Submit(SanitizeRequest{{}, {}, std::move(contents), std::move(properties), {}});
+	}
+
+	void SanitizeSession::Submit(Path input, Path output, Callback callback)
+	{
+		Submit(SanitizeRequest{std::move(input), std::move(output), {}, {}, {}}, std::move(callback));
+	}
+
+	void SanitizeSession::Submit(string contents, DocumentProperty properties, Callback callback)
+	{
+		Submit(SanitizeRequest{{}, {}, std::move(contents), std::move(properties), {}}, std::move(callback));
+	}
+
+	SanitizeResult SanitizeSession::Clean(SanitizeRequest request)
+	{
+		return Run(request);
+	}
+
+	SanitizeResult SanitizeSession::Clean(const Path &input, const Path &output)
+	{
+		SanitizeRequest request{input, output, {}, {}, {}};
+		return Run(request);
+	}
+
+	SanitizeResult SanitizeSession::Clean(string contents, const DocumentProperty &properties)
+	{
+		SanitizeRequest request{{}, {}, std::move(contents), properties, {}};
+		return Run(request);
+	}
+
+	void SanitizeSession::Wait()
+	{
+		m_pool.Wait();
+	}
+
+	SanitizeSession::Path SanitizeSession::GetOutputPath(const Path &input) const
+	{
+		auto name = input.filename().generic_string();
+
+		if (m_options.prefix)
+		{
+			if (auto index = name.find(m_options.prefix); index != string::npos)
+			{
+				name.erase(index, 1);
+			}
+		}
+
+		return (m_options.outputDirectory.empty() ? input.parent_path() : m_options.outputDirectory) / name;
+	}
+
+	PatternSetPtr SanitizeSession::GetPatterns() const noexcept
+	{
+		return m_patterns;
+	}
+
+	const SessionOptions &SanitizeSession::GetOptions() const noexcept
+	{
+		return m_options;
+	}
+
+	SanitizeResult SanitizeSession::Run(SanitizeRequest &request)
+	{
+		SanitizeResult            result{};
+		MemoryBudget::Reservation reservation{};
+		auto                      start    = Clock::now();
+		bool                      inMemory = request.input.empty();
+		auto                      patterns = request.patterns ? request.patterns : m_patterns;
+
+		if (not inMemory and request.output.empty())
+		{
+			request.output = GetOutputPath(request.input);
+		}
+
+		result.input  = request.input;
+		result.output = request.output;
+
+		try
+		{
+			if (not Read(request, request.patterns ? nullptr : m_prefilter.get(), reservation))
+			{
+				return result;
+			}
+			result.readTime = secondsSince(start);
+
+			// A label stands in for the path of documents given in memory
+			Inspector inspector(inMemory ? Path("<memory>") : request.input, std::move(request.contents),
+			                    patterns, m_options.inspector);
+
+			if (not inspector.Load())
+			{
+				throw runtime_error("Cannot parse document");
+			}
+			result.parseTime = secondsSince(start);
+
+			inspector.DeleteAll(m_options.pages);
+			result.keywords  = inspector.GetKeywords();
+			result.cleanTime = secondsSince(start);
+
+			if (not inspector.Done())
+			{
+				return result;
+			}
+
+			if (request.properties)
+			{
+				inspector.SetDocumentProperties(*request.properties);
+			}
+			else if (not inMemory)
+			{
+				inspector.SetDocumentProperties(m_options.properties
+				                                ? m_options.properties(request.input)
+				                                : DocumentProperty::FromFileName(request.input, m_options.prefix));
+			}
+
+			if (inMemory)
+			{
+				result.contents = inspector.WriteToBuffer();
+			}
+			else
+			{
+				inspector.Write(request.output.generic_string());
+
+				boost::system::error_code error{};
+				bool                      inPlace = boost::filesystem::equivalent(request.input, request.output, error);
+
+				if (m_options.prefix and m_options.replace and not inPlace)
+				{
+					boost::filesystem::remove(request.input);
+				}
+			}
+
+			result.writeTime = secondsSince(start);
+			result.status    = SanitizeResult::Status::Cleaned;
+		}
+		catch (PdfError &error)
+		{
+			result.status = SanitizeResult::Status::Failed;
+			result.error  = error.what();
+		}
+		catch (std::exception &error)
+		{
+			result.status = SanitizeResult::Status::Failed;
+			result.error  = error.what();
+		}
+
+		return result;
+	}
+
+	bool SanitizeSession::Read(SanitizeRequest &request, const Prefilter *prefilter, MemoryBudget::Reservation &reservation)
+	{
+		if (request.input.empty())
+		{
+			if (request.contents.empty())
+			{
+				throw invalid_argument("Empty document");
+			}
+
+			if (prefilter and not prefilter->IsCandidate(string_view(request.contents)))
+			{
+				return false;
+			}
+
+			if (m_budget)
+			{
+				auto need = MemoryBudget::Estimate(request.contents.size(), MemoryBudget::CountPages(request.contents));
+				reservation = m_budget->Acquire(need);
+			}
+			return true;
+		}
+
+		// Estimating and prefiltering look at the raw bytes before anything is copied
+		MappedFile mapping{};
+		if (prefilter or m_budget)
+		{
+			mapping = MappedFile(request.input);
+		}
+
+		if (prefilter and mapping.IsOpen() and not prefilter->IsCandidate(mapping.View()))
+		{
+			return false;
+		}
+
+		if (m_budget)
+		{
+			boost::system::error_code error{};
+			auto                      size = mapping.IsOpen() ? mapping.View().size()
+			                                                  : boost::filesystem::file_size(request.input, error);
+			auto                      need = MemoryBudget::Estimate(error ? 0 : size, MemoryBudget::CountPages(mapping.View()));
+
+			reservation = m_budget->Acquire(need);
+		}
+
+		// A mapped document is paged in by the kernel while it is parsed
+		if (m_options.inspector.mapped)
+		{
+			return true;
+		}
+
+		TraceSpan span("Read", request.input.native());
+
+		if (mapping.IsOpen())
+		{
+			request.contents.assign(mapping.View());
+		}
+		else
+		{
+			boost::filesystem::ifstream stream(request.input, ios::binary);
+			if (not stream)
+			{
+				throw runtime_error("Cannot open file");
+			}
+			request.contents.assign(istreambuf_iterator<char>(stream), istreambuf_iterator<char>());
+		}
+
+		span.SetBytes(static_cast<int64_t>(request.contents.size()));
+		return true;
+	}
+}
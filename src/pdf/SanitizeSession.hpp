@@ -0,0 +1,191 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "Common.hpp"
+#include "DocumentProperty.hpp"
+#include "Inspector.hpp"
+#include "Keyword.hpp"
+#include "MemoryBudget.hpp"
+#include "PageSelection.hpp"
+#include "Pattern.hpp"
+#include "Prefilter.hpp"
+#include "ThreadPool.hpp"
+
+namespace PDF
+{
+	struct SessionOptions
+	{
+		/// Uri regexes whose links and resources are removed
+		std::vector<std::string> uris;
+
+		/// How each document is parsed, cleaned and written
+		InspectorOptions inspector;
+
+		/// Documents cleaned at once
+		size_t jobs{ThreadPool::DefaultSize()};
+
+		/// Pages searched and cleaned in every document
+		PageSelection pages;
+
+		/// Skip files whose raw bytes cannot contain a match
+		bool prefilter{};
+
+		/// Memory budget of documents in flight, none when zero
+		size_t maxMemory{};
+
+		/// Character marking input file names, dropped from the output name
+		char prefix{};
+
+		/// Remove a prefixed input once its cleaned output is written
+		bool replace{};
+
+		/// Directory outputs are written to, next to the input when empty
+		boost::filesystem::path outputDirectory;
+
+		/// Properties of a cleaned file, DocumentProperty::FromFileName() when empty
+		std::function<DocumentProperty(const boost::filesystem::path &)> properties;
+	};
+
+	/// One document to clean, the file at input or the contents when input is empty
+	struct SanitizeRequest
+	{
+		boost::filesystem::path input;
+
+		/// SanitizeSession::GetOutputPath(input) when empty
+		boost::filesystem::path output;
+
+		std::string contents;
+
+		/// Files get the properties of the session's rule when not set
+		std::optional<DocumentProperty> properties;
+
+		/// The session's patterns when null, the prefilter only applies to those
+		PatternSetPtr patterns;
+	};
+
+	struct SanitizeResult
+	{
+		enum class Status
+		{
+			Cleaned,   // Matches removed and the output written
+			Unchanged, // Nothing matched, no output written
+			Failed     // See error
+		};
+
+		Status status{Status::Unchanged};
+
+		/// Empty for documents given in memory
+		boost::filesystem::path input;
+
+		boost::filesystem::path output;
+
+		/// Cleaned document of an in-memory job
+		std::string contents;
+
+		KeywordMatcher::Keywords keywords;
+
+		std::string error;
+
+		/// Seconds spent in each stage
+		double readTime{};
+
+		double parseTime{};
+
+		double cleanTime{};
+
+		double writeTime{};
+	};
+
+	/**
+	 * Cleans documents with settings given once. The compiled patterns,
+	 * prefilter, memory budget and worker threads are kept for the whole
+	 * session, so embedding applications pay for them only once.
+	 * Submitted documents are cleaned concurrently, results come back
+	 * through futures or callbacks run on a worker thread.
+	 */
+	class SanitizeSession
+	{
+	public:
+		using Path = boost::filesystem::path;
+
+		using Callback = std::function<void(SanitizeResult)>;
+
+		/// Throws std::invalid_argument when a pattern does not compile
+		explicit SanitizeSession(SessionOptions options);
+
+		SanitizeSession(const SanitizeSession &) = delete;
+
+		SanitizeSession &operator=(const SanitizeSession &) = delete;
+
+		/// Waits for the documents still being cleaned
+		~SanitizeSession();
+
+		std::future<SanitizeResult> Submit(SanitizeRequest request);
+
+		void Submit(SanitizeRequest request, Callback callback);
+
+		/// Cleans input into GetOutputPath(input)
+		std::future<SanitizeResult> Submit(Path input);
+
+		std::future<SanitizeResult> Submit(Path input, Path output);
+
+		/// Cleans a document held in memory, the result holds the cleaned bytes
+		std::future<SanitizeResult> Submit(std::string contents, DocumentProperty properties);
+
+		void Submit(Path input, Path output, Callback callback);
+
+		void Submit(std::string contents, DocumentProperty properties, Callback callback);
+
+		/// Cleans on the calling thread
+		SanitizeResult Clean(SanitizeRequest request);
+
+		SanitizeResult Clean(const Path &input, const Path &output);
+
+		SanitizeResult Clean(std::string contents, const DocumentProperty &properties);
+
+		/// Blocks until every submitted document is done
+		void Wait();
+
+		NODISCARD
+		Path GetOutputPath(const Path &input) const;
+
+		NODISCARD
+		PatternSetPtr GetPatterns() const noexcept;
+
+		NODISCARD
+		const SessionOptions &GetOptions() const noexcept;
+
+	private:
+		SanitizeResult Run(SanitizeRequest &request);
+
+		/// Reads the file of request unless filtered out, false when it needs no work
+		bool Read(SanitizeRequest &request, const Prefilter *prefilter, MemoryBudget::Reservation &reservation);
+
+	private:
+		SessionOptions m_options;
+
+		PatternSetPtr m_patterns;
+
+		std::unique_ptr<Prefilter> m_prefilter;
+
+		std::unique_ptr<MemoryBudget> m_budget;
+
+		// Declared last, the workers stop before anything they use is destroyed
+		ThreadPool m_pool;
+	};
+}
@@ -0,0 +1,334 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "MappedFile.hpp"
+#include "ScanCache.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	static const char *g_cacheHeader{"pdfsanitizer-cache 3"};
+
+	static const uint64_t g_fnvPrime{0x100000001b3ULL};
+
+	static const int64_t g_nanoseconds{1000000000};
+
+	/// Escapes the field and list separators of the cache file
+	static string escapeField(string_view field)
+	{
+		string escaped{};
+
+		for (char c : field)
+		{
+			switch (c)
+			{
+				case '\\':
+					escaped.append("\\\\");
+					break;
+				case '\t':
+					escaped.append("\\t");
+					break;
+				case '\n':
+					escaped.append("\\n");
+					break;
+				case ',':
+					escaped.append("\\c");
+					break;
+				default:
+					escaped.push_back(c);
+			}
+		}
+		return escaped;
+	}
+
+	static string unescapeField(string_view field)
+	{
+		string unescaped{};
+
+		for (size_t i{}; i < field.size(); ++i)
+		{
+			if (field[i] != '\\' or i + 1 == field.size())
+			{
+				unescaped.push_back(field[i]);
+				continue;
+			}
+
+			switch (field[++i])
+			{
+				case 't':
+					unescaped.push_back('\t');
+					break;
+				case 'n':
+					unescaped.push_back('\n');
+					break;
+				case 'c':
+					unescaped.push_back(',');
+					break;
+				default:
+					unescaped.push_back(field[i]);
+			}
+		}
+		return unescaped;
+	}
+
+	static vector<string_view> splitFields(string_view line, char separator)
+	{
+		vector<string_view> fields{};
+		size_t              begin{};
+
+		for (;;)
+		{
+			auto end = line.find(separator, begin);
+			fields.push_back(line.substr(begin, end - begin));
+
+			if (end == string_view::npos)
+			{
+				break;
+			}
+			begin = end + 1;
+		}
+		return fields;
+	}
+
+	ScanCache::ScanCache(Path cacheFile, const PatternSet &patterns, string_view settings)
+			: m_cacheFile(std::move(cacheFile)),
+			  m_runHash(HashBytes(settings, HashPatterns(patterns))),
+			  m_entries()
+	{}
+
+	void ScanCache::Load()
+	{
+		ifstream input(m_cacheFile.generic_string());
+		string   line{};
+
+		if (not input or not getline(input, line) or line != g_cacheHeader)
+		{
+			return;
+		}
+
+		lock_guard l(m_mutex);
+
+		while (getline(input, line))
+		{
+			auto fields = splitFields(line, '\t');
+
+			if (fields.size() != 8)
+			{
+				continue;
+			}
+
+			try
+			{
+				Entry entry{};
+				entry.size        = stoull(string(fields[1]));
+				entry.modified    = stoll(string(fields[2]));
+				entry.recorded    = static_cast<time_t>(stoll(string(fields[3])));
+				entry.contentHash = stoull(string(fields[4]), nullptr, 16);
+				entry.runHash     = stoull(string(fields[5]), nullptr, 16);
+				entry.outcome     = static_cast<Outcome>(stoi(string(fields[6])));
+
+				if (not fields[7].empty())
+				{
+					for (auto keyword : splitFields(fields[7], ','))
+					{
+						entry.keywords.push_back(unescapeField(keyword));
+					}
+				}
+
+				m_entries[unescapeField(fields[0])] = std::move(entry);
+			}
+			catch (logic_error &)
+			{
+				// Damaged line, the file is simply scanned again
+			}
+		}
+	}
+
+	void ScanCache::Save() const
+	{
+		auto          temporary = m_cacheFile.generic_string() + ".tmp";
+		ofstream      output(temporary, ios::trunc);
+		ostringstream keywords{};
+
+		if (not output)
+		{
+			cerr << "Cache \'" << m_cacheFile.generic_string() << "\' cannot be written" << endl;
+			return;
+		}
+
+		{
+			lock_guard l(m_mutex);
+			output << g_cacheHeader << '\n';
+
+			for (const auto &[path, entry] : m_entries)
+			{
+				output << escapeField(path) << '\t'
+				       << entry.size << '\t'
+				       << static_cast<long long>(entry.modified) << '\t'
+				       << static_cast<long long>(entry.recorded) << '\t'
+				       << hex << entry.contentHash << '\t'
+				       << entry.runHash << dec << '\t'
+				       << static_cast<int>(entry.outcome) << '\t';
+
+				for (size_t i{}; i < entry.keywords.size(); ++i)
+				{
+					output << (i ? "," : "") << escapeField(entry.keywords[i]);
+				}
+				output << '\n';
+			}
+		}
+
+		output.close();
+
+		boost::system::error_code error{};
+		boost::filesystem::rename(temporary, m_cacheFile, error);
+		if (error)
+		{
+			cerr << "Cache \'" << m_cacheFile.generic_string() << "\' cannot be replaced: " << error.message() << endl;
+		}
+	}
+
+	bool ScanCache::IsUpToDate(const Path &path, const Path &output, Source &source)
+	{
+		auto &size     = source.size;
+		auto &modified = source.modified;
+
+		if (not Stat(path, size, modified))
+		{
+			return false;
+		}
+
+		unique_lock l(m_mutex);
+		auto        iter = m_entries.find(path.generic_string());
+
+		if (iter == m_entries.end() or iter->second.runHash != m_runHash or iter->second.size != size)
+		{
+			return false;
+		}
+
+		switch (iter->second.outcome)
+		{
+			case Outcome::NoMatch:
+				break;
+			case Outcome::Cleaned:
+				if (not boost::filesystem::exists(output))
+				{
+					return false;
+				}
+				break;
+			case Outcome::Error:
+				return false;
+		}
+
+		// A file rewritten within the second its entry was recorded may keep the
+		// same time on filesystems with coarse timestamps, so it is hashed too
+		if (iter->second.modified == modified and modified / g_nanoseconds < iter->second.recorded)
+		{
+			return true;
+		}
+
+		// Touched but maybe not changed, hashing is still far cheaper than parsing
+		auto expected = iter->second.contentHash;
+		l.unlock();
+
+		if (HashFile(path) != expected)
+		{
+			return false;
+		}
+
+		l.lock();
+		if (iter = m_entries.find(path.generic_string()); iter != m_entries.end())
+		{
+			iter->second.modified = modified;
+			iter->second.recorded = time(nullptr);
+		}
+		return true;
+	}
+
+	void ScanCache::Record(const Path &path, const Source &source, Outcome outcome,
+	                       const KeywordMatcher::Keywords &keywords)
+	{
+		Entry entry{};
+		entry.size        = source.size;
+		entry.modified    = source.modified;
+		entry.recorded    = time(nullptr);
+		entry.contentHash = source.contentHash;
+		entry.runHash     = m_runHash;
+		entry.outcome     = outcome;
+		entry.keywords.assign(keywords.begin(), keywords.end());
+
+		lock_guard l(m_mutex);
+		m_entries[path.generic_string()] = std::move(entry);
+	}
+
+	void ScanCache::Forget(const Path &path)
+	{
+		lock_guard l(m_mutex);
+		m_entries.erase(path.generic_string());
+	}
+
+	bool ScanCache::Describe(const Path &path, Source &source)
+	{
+		if (not Stat(path, source.size, source.modified))
+		{
+			return false;
+		}
+
+		source.contentHash = HashFile(path);
+		return true;
+	}
+
+	uint64_t ScanCache::HashBytes(string_view data, uint64_t seed)
+	{
+		// FNV-1a
+		for (unsigned char byte : data)
+		{
+			seed ^= byte;
+			seed *= g_fnvPrime;
+		}
+		return seed;
+	}
+
+	uint64_t ScanCache::HashFile(const Path &path)
+	{
+		MappedFile file(path);
+		return HashBytes(file.View());
+	}
+
+	uint64_t ScanCache::HashPatterns(const PatternSet &patterns)
+	{
+		uint64_t hash = HashSeed;
+
+		for (const auto &pattern : patterns)
+		{
+			hash = HashBytes(pattern.GetSource(), hash);
+			hash = HashBytes(string_view("\0", 1), hash);
+		}
+		return hash;
+	}
+
+	bool ScanCache::Stat(const Path &path, uintmax_t &size, int64_t &modified)
+	{
+		struct stat info{};
+
+		if (::stat(path.c_str(), &info) != 0 or not S_ISREG(info.st_mode))
+		{
+			return false;
+		}
+
+		size     = static_cast<uintmax_t>(info.st_size);
+		modified = static_cast<int64_t>(info.st_mtim.tv_sec) * g_nanoseconds + info.st_mtim.tv_nsec;
+		return true;
+	}
+}
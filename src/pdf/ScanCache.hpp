@@ -0,0 +1,121 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <ctime>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "Common.hpp"
+#include "Keyword.hpp"
+#include "Pattern.hpp"
+
+namespace PDF
+{
+	/**
+	 * Outcome of previous runs kept on disk, so that files known to be clean
+	 * are skipped without being opened. Entries are keyed by path and checked
+	 * against size, modification time and a content hash, and only apply to
+	 * runs with the same uri patterns and the same settings changing what is
+	 * cleaned, such as the page selection.
+	 */
+	class ScanCache
+	{
+	public:
+		using Path = boost::filesystem::path;
+
+		enum class Outcome
+		{
+			NoMatch, // Nothing to clean in the file
+			Cleaned, // Matches were removed and the output written
+			Error    // The file could not be processed
+		};
+
+		struct Entry
+		{
+			uintmax_t size{};
+
+			/// Nanoseconds since the epoch
+			int64_t modified{};
+
+			/// Second the content was last known to match, a modification within it is not trusted
+			std::time_t recorded{};
+
+			uint64_t contentHash{};
+
+			/// Patterns and settings of the run that recorded the entry
+			uint64_t runHash{};
+
+			Outcome outcome{};
+
+			std::vector<std::string> keywords;
+		};
+
+		/// What an entry is checked against, taken from the bytes that were processed
+		struct Source
+		{
+			uintmax_t size{};
+
+			/// Nanoseconds since the epoch, 0 when unknown
+			int64_t modified{};
+
+			uint64_t contentHash{};
+		};
+
+		/// Settings is any text naming the options that change the outcome of a file
+		ScanCache(Path cacheFile, const PatternSet &patterns, std::string_view settings);
+
+		/// Reads the cache file, a missing or unreadable file leaves the cache empty
+		void Load();
+
+		/// Replaces the cache file atomically
+		void Save() const;
+
+		/**
+		 * True if the file has no matches or was already cleaned into an
+		 * output that still exists, and has not changed since then. Fills
+		 * the size and modification time of source either way.
+		 */
+		bool IsUpToDate(const Path &path, const Path &output, Source &source);
+
+		/// Stores the outcome for content described beforehand, the file is not touched
+		void Record(const Path &path, const Source &source, Outcome outcome, const KeywordMatcher::Keywords &keywords);
+
+		/// Drops the entry of a file that no longer exists
+		void Forget(const Path &path);
+
+		/// Reads size, modification time and content hash, false if the file is gone
+		static bool Describe(const Path &path, Source &source);
+
+		static uint64_t HashBytes(std::string_view data, uint64_t seed = HashSeed);
+
+		static uint64_t HashFile(const Path &path);
+
+		static uint64_t HashPatterns(const PatternSet &patterns);
+
+	private:
+		static constexpr uint64_t HashSeed = 0xcbf29ce484222325ULL;
+
+		static bool Stat(const Path &path, uintmax_t &size, int64_t &modified);
+
+	private:
+		mutable std::mutex m_mutex;
+
+		Path m_cacheFile;
+
+		uint64_t m_runHash;
+
+		std::unordered_map<std::string, Entry> m_entries;
+	};
+}
@@ -0,0 +1,372 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Server.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	using Clock = chrono::steady_clock;
+
+	/// Bytes read from a connection at a time
+	static constexpr size_t g_readSize = 64 * 1024;
+
+	/// Longest job line accepted, the connection is dropped past it
+	static constexpr size_t g_maxLineLength = 1024 * 1024;
+
+	/// Distinct pattern lists kept compiled
+	static constexpr size_t g_maxPatternSets = 64;
+
+	static const char *statusName(SanitizeResult::Status status)
+	{
+		switch (status)
+		{
+			case SanitizeResult::Status::Cleaned:
+				return "cleaned";
+			case SanitizeResult::Status::Unchanged:
+				return "unchanged";
+			default:
+				return "failed";
+		}
+	}
+
+	static string optionalString(const Json &value)
+	{
+		return value.IsNull() ? string() : value.AsString();
+	}
+
+	struct Server::Connection
+	{
+		int input;
+
+		int output;
+
+		/// Closed with the connection, standard streams are not
+		bool owned;
+
+		std::mutex mutex;
+
+		Connection(int anInput, int anOutput, bool anOwned) noexcept
+				: input(anInput),
+				  output(anOutput),
+				  owned(anOwned)
+		{}
+
+		~Connection()
+		{
+			if (owned)
+			{
+				close(input);
+			}
+		}
+
+		/// Writes one response line, a peer gone away is ignored
+		void Send(string line)
+		{
+			line.push_back('\n');
+
+			lock_guard l(mutex);
+			for (size_t written{}; written < line.size();)
+			{
+				auto count = write(output, line.data() + written, line.size() - written);
+				if (count < 0 and errno == EINTR)
+				{
+					continue;
+				}
+				if (count <= 0)
+				{
+					return;
+				}
+				written += static_cast<size_t>(count);
+			}
+		}
+	};
+
+	Server::Server(SessionOptions options)
+			: m_session(std::move(options)),
+			  m_mutex(),
+			  m_patterns(),
+			  m_clients(),
+			  m_clientsDone()
+	{
+		// Writing to a client that hung up must not end the process
+		signal(SIGPIPE, SIG_IGN);
+	}
+
+	void Server::ServeStream(int input, int output)
+	{
+		Serve(make_shared<Connection>(input, output, false));
+		m_session.Wait();
+	}
+
+	void Server::ServeSocket(const string &socketPath)
+	{
+		sockaddr_un address{};
+
+		if (socketPath.size() >= sizeof(address.sun_path))
+		{
+			throw invalid_argument("Socket path too long: " + socketPath);
+		}
+		address.sun_family = AF_UNIX;
+		strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+		int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (listener < 0)
+		{
+			throw system_error(errno, generic_category(), "socket");
+		}
+
+		// A socket left behind by a previous run would make bind fail
+		struct stat status{};
+		if (lstat(socketPath.c_str(), &status) == 0 and S_ISSOCK(status.st_mode))
+		{
+			unlink(socketPath.c_str());
+		}
+
+		if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0
+		    or listen(listener, SOMAXCONN) < 0)
+		{
+			auto error = errno;
+			close(listener);
+			throw system_error(error, generic_category(), socketPath);
+		}
+
+		int error{};
+		for (;;)
+		{
+			int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+			if (client < 0)
+			{
+				if (errno == EINTR or errno == ECONNABORTED)
+				{
+					continue;
+				}
+				error = errno;
+				break;
+			}
+
+			{
+				lock_guard l(m_mutex);
+				m_clients.insert(client);
+			}
+
+			thread([this, client]
+			       {
+				       auto connection = make_shared<Connection>(client, client, true);
+				       Serve(connection);
+
+				       // Answers still on their way keep the socket open through the connection
+				       lock_guard l(m_mutex);
+				       m_clients.erase(client);
+				       m_clientsDone.notify_all();
+			       }).detach();
+		}
+
+		close(listener);
+		unlink(socketPath.c_str());
+
+		// Readers still blocked on their clients are woken up before the server goes away
+		{
+			unique_lock l(m_mutex);
+			for (int client : m_clients)
+			{
+				shutdown(client, SHUT_RD);
+			}
+			m_clientsDone.wait(l, [this] { return m_clients.empty(); });
+		}
+		m_session.Wait();
+
+		throw system_error(error, generic_category(), "accept");
+	}
+
+	void Server::Serve(const shared_ptr<Connection> &connection)
+	{
+		string buffer{};
+		char   chunk[g_readSize];
+
+		for (;;)
+		{
+			auto count = read(connection->input, chunk, sizeof(chunk));
+			if (count < 0 and errno == EINTR)
+			{
+				continue;
+			}
+			if (count <= 0)
+			{
+				break;
+			}
+			buffer.append(chunk, static_cast<size_t>(count));
+
+			size_t begin{};
+			for (size_t end; (end = buffer.find('\n', begin)) != string::npos; begin = end + 1)
+			{
+				Handle(connection, string_view(buffer).substr(begin, end - begin));
+			}
+			buffer.erase(0, begin);
+
+			if (buffer.size() > g_maxLineLength)
+			{
+				Json response{};
+				response["status"] = "failed";
+				response["error"]  = "Job line too long";
+				connection->Send(response.Dump());
+				return;
+			}
+		}
+
+		// A last job without a line break
+		Handle(connection, buffer);
+	}
+
+	void Server::Handle(const shared_ptr<Connection> &connection, string_view line)
+	{
+		while (not line.empty() and (line.back() == '\r' or line.back() == ' ' or line.back() == '\t'))
+		{
+			line.remove_suffix(1);
+		}
+		if (line.empty())
+		{
+			return;
+		}
+
+		auto received = Clock::now();
+		Json id{};
+
+		try
+		{
+			const auto      job = Json::Parse(line);
+			SanitizeRequest request{};
+
+			id = job["id"];
+			request.input = optionalString(job["input"]);
+			if (request.input.empty())
+			{
+				throw invalid_argument("Missing input");
+			}
+			request.output = optionalString(job["output"]);
+
+			if (const auto &properties = job["properties"]; not properties.IsNull())
+			{
+				if (properties.GetType() != Json::Type::Object)
+				{
+					throw invalid_argument("Properties must be an object");
+				}
+
+				DocumentProperty documentProperty{};
+				documentProperty.title    = optionalString(properties["title"]);
+				documentProperty.author   = optionalString(properties["author"]);
+				documentProperty.subject  = optionalString(properties["subject"]);
+				documentProperty.creator  = optionalString(properties["creator"]);
+				documentProperty.producer = optionalString(properties["producer"]);
+				documentProperty.keywords = optionalString(properties["keywords"]);
+				request.properties        = std::move(documentProperty);
+			}
+
+			if (const auto &patterns = job["patterns"]; not patterns.IsNull())
+			{
+				request.patterns = GetPatterns(patterns);
+			}
+			else if (m_session.GetPatterns()->Empty())
+			{
+				throw invalid_argument("No patterns given to the server nor to the job");
+			}
+
+			m_session.Submit(std::move(request), [connection, id, received](SanitizeResult result)
+			{
+				Json response{}, timings{};
+				Json::Array keywords(result.keywords.begin(), result.keywords.end());
+				double total = chrono::duration<double>(Clock::now() - received).count();
+				double work  = result.readTime + result.parseTime + result.cleanTime + result.writeTime;
+
+				timings["queue"] = max(total - work, 0.0);
+				timings["read"]  = result.readTime;
+				timings["parse"] = result.parseTime;
+				timings["clean"] = result.cleanTime;
+				timings["write"] = result.writeTime;
+				timings["total"] = total;
+
+				if (not id.IsNull())
+				{
+					response["id"] = id;
+				}
+				response["status"]   = statusName(result.status);
+				response["input"]    = result.input.generic_string();
+				response["output"]   = result.output.generic_string();
+				response["keywords"] = std::move(keywords);
+				response["timings"]  = std::move(timings);
+
+				if (not result.error.empty())
+				{
+					response["error"] = result.error;
+				}
+				connection->Send(response.Dump());
+			});
+		}
+		catch (std::exception &e)
+		{
+			Json response{};
+
+			if (not id.IsNull())
+			{
+				response["id"] = id;
+			}
+			response["status"] = "failed";
+			response["error"]  = e.what();
+			connection->Send(response.Dump());
+		}
+	}
+
+	PatternSetPtr Server::GetPatterns(const Json &sources)
+	{
+		vector<string> uris{};
+
+		for (const auto &source : sources.AsArray())
+		{
+			uris.push_back(source.AsString());
+		}
+
+		if (uris.empty())
+		{
+			throw invalid_argument("Empty pattern list");
+		}
+
+		{
+			lock_guard l(m_mutex);
+			if (auto found = m_patterns.find(uris); found != m_patterns.end())
+			{
+				return found->second;
+			}
+		}
+
+		// Compiled unlocked so one client's patterns do not hold up the others,
+		// throws std::invalid_argument on a pattern that does not compile or is too large
+		auto patterns = make_shared<const PatternSet>(uris);
+
+		lock_guard l(m_mutex);
+		if (m_patterns.size() >= g_maxPatternSets)
+		{
+			m_patterns.clear();
+		}
+
+		// Another connection may have compiled the same list meanwhile
+		return m_patterns.emplace(std::move(uris), patterns).first->second;
+	}
+}
@@ -0,0 +1,69 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Json.hpp"
+#include "SanitizeSession.hpp"
+
+namespace PDF
+{
+	/**
+	 * Long-running front end of a SanitizeSession. Jobs come one JSON
+	 * object per line, from a Unix domain socket or from a stream:
+	 *
+	 *   {"id": 1, "input": "in.pdf", "output": "out.pdf",
+	 *    "properties": {"title": "..", "author": ".."}, "patterns": [".."]}
+	 *
+	 * Only input is required. Every job is answered with one line holding
+	 * its id, status, matched keywords and stage timings in seconds, in
+	 * the order the jobs finish.
+	 */
+	class Server
+	{
+	public:
+		explicit Server(SessionOptions options);
+
+		/// Serves the jobs read from input until it is closed and every job is answered
+		void ServeStream(int input, int output);
+
+		/// Accepts connections on socketPath until accepting fails, throws std::system_error
+		void ServeSocket(const std::string &socketPath);
+
+	private:
+		struct Connection;
+
+		void Serve(const std::shared_ptr<Connection> &connection);
+
+		void Handle(const std::shared_ptr<Connection> &connection, std::string_view line);
+
+		/// Compiled once per distinct pattern list
+		PatternSetPtr GetPatterns(const Json &sources);
+
+	private:
+		SanitizeSession m_session;
+
+		std::mutex m_mutex;
+
+		std::map<std::vector<std::string>, PatternSetPtr> m_patterns;
+
+		// Sockets of the connections still being read
+		std::set<int> m_clients;
+
+		std::condition_variable m_clientsDone;
+	};
+}
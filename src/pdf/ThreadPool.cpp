@@ -0,0 +1,115 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <iostream>
+
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	ThreadPool::ThreadPool(size_t threadCount)
+			: m_stopped(false),
+			  m_active(0),
+			  m_tasks(),
+			  m_workers()
+	{
+		threadCount = max<size_t>(threadCount, 1);
+		m_workers.reserve(threadCount);
+
+		for (size_t i{}; i < threadCount; ++i)
+		{
+			m_workers.emplace_back(&ThreadPool::Run, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			lock_guard l(m_mutex);
+			m_stopped = true;
+		}
+		m_taskReady.notify_all();
+
+		for (auto &worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::Submit(Task task)
+	{
+		{
+			lock_guard l(m_mutex);
+			m_tasks.push_back(std::move(task));
+		}
+		m_taskReady.notify_one();
+	}
+
+	void ThreadPool::Wait()
+	{
+		unique_lock l(m_mutex);
+		m_idle.wait(l, [this] { return m_tasks.empty() and not m_active; });
+	}
+
+	size_t ThreadPool::GetSize() const noexcept
+	{
+		return m_workers.size();
+	}
+
+	size_t ThreadPool::DefaultSize() noexcept
+	{
+		auto cores = thread::hardware_concurrency();
+		return cores ? cores : 1;
+	}
+
+	void ThreadPool::Run()
+	{
+		for (;;)
+		{
+			Task task;
+			{
+				unique_lock l(m_mutex);
+				m_taskReady.wait(l, [this] { return m_stopped or not m_tasks.empty(); });
+
+				// Drain the queue before honoring a stop request
+				if (m_tasks.empty())
+				{
+					return;
+				}
+
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+				++m_active;
+			}
+
+			try
+			{
+				task();
+			}
+			catch (exception &e)
+			{
+				cerr << "Task failed: " << e.what() << endl;
+			}
+			catch (...)
+			{
+				cerr << "Task failed with an unknown error" << endl;
+			}
+
+			{
+				lock_guard l(m_mutex);
+				--m_active;
+				if (m_tasks.empty() and not m_active)
+				{
+					m_idle.notify_all();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,67 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common.hpp"
+
+namespace PDF
+{
+	/**
+	 * Fixed-size pool of worker threads consuming tasks in submission order.
+	 * Exceptions thrown by a task are reported and do not stop the worker.
+	 */
+	class ThreadPool
+	{
+	public:
+		using Task = std::function<void()>;
+
+		explicit ThreadPool(size_t threadCount);
+
+		ThreadPool(const ThreadPool &) = delete;
+
+		ThreadPool &operator=(const ThreadPool &) = delete;
+
+		~ThreadPool();
+
+		void Submit(Task task);
+
+		/// Blocks until every submitted task has finished.
+		void Wait();
+
+		NODISCARD
+		size_t GetSize() const noexcept;
+
+		static size_t DefaultSize() noexcept;
+
+	private:
+		void Run();
+
+	private:
+		bool m_stopped;
+
+		size_t m_active;
+
+		std::mutex m_mutex;
+
+		std::condition_variable m_taskReady;
+
+		std::condition_variable m_idle;
+
+		std::deque<Task> m_tasks;
+
+		std::vector<std::thread> m_workers;
+	};
+}
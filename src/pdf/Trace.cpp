@@ -0,0 +1,205 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <boost/filesystem/fstream.hpp>
+
+#include "Trace.hpp"
+
+using namespace std;
+
+namespace PDF
+{
+	struct ThreadEvents
+	{
+		size_t id;
+
+		string name;
+
+		vector<Trace::Event> events;
+	};
+
+	static atomic<bool> g_traceEnabled{false};
+
+	static const auto g_traceStart = chrono::steady_clock::now();
+
+	static mutex g_threadsMutex;
+
+	// Kept alive past the end of their threads until the trace is written
+	static vector<shared_ptr<ThreadEvents>> g_threads;
+
+	static ThreadEvents &threadEvents()
+	{
+		thread_local shared_ptr<ThreadEvents> local;
+
+		if (not local)
+		{
+			lock_guard l(g_threadsMutex);
+			local = make_shared<ThreadEvents>();
+			local->id = g_threads.size() + 1;
+			g_threads.push_back(local);
+		}
+
+		return *local;
+	}
+
+	static void writeEscaped(ostream &stream, string_view text)
+	{
+		stream << '"';
+		for (char c : text)
+		{
+			switch (c)
+			{
+				case '"':
+					stream << "\\\"";
+					break;
+				case '\\':
+					stream << "\\\\";
+					break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20)
+					{
+						char code[8];
+						snprintf(code, sizeof(code), "\\u%04x", c);
+						stream << code;
+					}
+					else
+					{
+						stream << c;
+					}
+			}
+		}
+		stream << '"';
+	}
+
+	void Trace::Enable() noexcept
+	{
+		g_traceEnabled = true;
+	}
+
+	bool Trace::IsEnabled() noexcept
+	{
+		return g_traceEnabled.load(memory_order_relaxed);
+	}
+
+	void Trace::SetThreadName(string_view name)
+	{
+		if (IsEnabled())
+		{
+			threadEvents().name = name;
+		}
+	}
+
+	bool Trace::Write(const boost::filesystem::path &path)
+	{
+		boost::filesystem::ofstream stream(path, ios::trunc);
+		lock_guard                  l(g_threadsMutex);
+		bool                        first = true;
+
+		auto separate = [&stream, &first]
+		{
+			stream << (first ? "\n" : ",\n");
+			first = false;
+		};
+
+		stream << "{\"traceEvents\":[";
+
+		for (const auto &thread : g_threads)
+		{
+			if (not thread->name.empty())
+			{
+				separate();
+				stream << R"({"ph":"M","name":"thread_name","pid":1,"tid":)" << thread->id << R"(,"args":{"name":)";
+				writeEscaped(stream, thread->name);
+				stream << "}}";
+			}
+
+			for (const auto &event : thread->events)
+			{
+				separate();
+				stream << R"({"ph":"X","pid":1,"tid":)" << thread->id
+				       << R"(,"ts":)" << event.start << R"(,"dur":)" << event.duration << R"(,"name":)";
+				writeEscaped(stream, event.name);
+				stream << R"(,"args":{)";
+
+				const char *comma = "";
+				if (not event.file.empty())
+				{
+					stream << R"("file":)";
+					writeEscaped(stream, event.file);
+					comma = ",";
+				}
+				if (event.bytes >= 0)
+				{
+					stream << comma << R"("bytes":)" << event.bytes;
+					comma = ",";
+				}
+				if (event.count >= 0)
+				{
+					stream << comma << R"("count":)" << event.count;
+				}
+				stream << "}}";
+			}
+		}
+
+		stream << "\n]}\n";
+		return static_cast<bool>(stream);
+	}
+
+	int64_t Trace::Now() noexcept
+	{
+		return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - g_traceStart).count();
+	}
+
+	void Trace::Record(Event &&event)
+	{
+		threadEvents().events.push_back(std::move(event));
+	}
+
+	TraceSpan::TraceSpan(const char *name, string_view file)
+			: m_enabled(Trace::IsEnabled()),
+			  m_event{name, {}, 0, 0, -1, -1}
+	{
+		if (m_enabled)
+		{
+			m_event.file  = file;
+			m_event.start = Trace::Now();
+		}
+	}
+
+	TraceSpan::~TraceSpan()
+	{
+		if (m_enabled)
+		{
+			m_event.duration = Trace::Now() - m_event.start;
+
+			try
+			{
+				Trace::Record(std::move(m_event));
+			}
+			catch (...)
+			{
+				// Losing a span is better than terminating from a destructor
+			}
+		}
+	}
+
+	void TraceSpan::SetBytes(int64_t bytes) noexcept
+	{
+		m_event.bytes = bytes;
+	}
+
+	void TraceSpan::SetCount(int64_t count) noexcept
+	{
+		m_event.count = count;
+	}
+}
@@ -0,0 +1,85 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <boost/filesystem.hpp>
+
+#include "Common.hpp"
+
+namespace PDF
+{
+	/**
+	 * Process-wide recorder of timed spans, written in the Chrome trace
+	 * event format. Each thread appends to its own buffer, so Write must
+	 * only be called once every recording thread has finished.
+	 * Recording costs one flag check while the trace is disabled.
+	 */
+	class Trace
+	{
+	public:
+		static void Enable() noexcept;
+
+		NODISCARD
+		static bool IsEnabled() noexcept;
+
+		/// Names the calling thread in the timeline
+		static void SetThreadName(std::string_view name);
+
+		static bool Write(const boost::filesystem::path &path);
+
+		/// Completed span, bytes and count are negative when not set
+		struct Event
+		{
+			const char *name;
+
+			std::string file;
+
+			int64_t start;
+
+			int64_t duration;
+
+			int64_t bytes;
+
+			int64_t count;
+		};
+
+	private:
+		friend class TraceSpan;
+
+		static int64_t Now() noexcept;
+
+		static void Record(Event &&event);
+	};
+
+	/// Span from construction to destruction on the calling thread
+	class TraceSpan
+	{
+	public:
+		explicit TraceSpan(const char *name, std::string_view file = {});
+
+		TraceSpan(const TraceSpan &) = delete;
+
+		TraceSpan &operator=(const TraceSpan &) = delete;
+
+		~TraceSpan();
+
+		void SetBytes(int64_t bytes) noexcept;
+
+		void SetCount(int64_t count) noexcept;
+
+	private:
+		bool m_enabled;
+
+		Trace::Event m_event;
+	};
+}
@@ -0,0 +1,139 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <memory>
+#include <set>
+#include <string>
+#include <podofo/podofo.h>
+
+#include "pdf/ContentFilter.hpp"
+#include "Test.hpp"
+
+using namespace PDF;
+using namespace PoDoFo;
+using namespace std;
+
+static const set<string> g_names{"Im1", "Sh1", "GS1"};
+
+/// Filters content handed over in pieces of chunk bytes
+static string filter(string_view content, size_t chunk, size_t *removed = nullptr)
+{
+	string        output{};
+	ContentFilter contentFilter(g_names, [&output](string_view data) { output.append(data); });
+
+	for (size_t offset{}; offset < content.size(); offset += chunk)
+	{
+		contentFilter.Write(content.substr(offset, chunk));
+	}
+	contentFilter.Finish();
+
+	if (removed)
+	{
+		*removed = contentFilter.GetRemovedCount();
+	}
+	return output;
+}
+
+/// Same output whatever the content is split into
+static bool filtersTo(string_view content, string_view expected)
+{
+	for (size_t chunk = 1; chunk <= content.size(); ++chunk)
+	{
+		if (filter(content, chunk) != expected)
+		{
+			return false;
+		}
+	}
+	return filter(content, content.size() + 1) == expected;
+}
+
+TEST_CASE(DropsRemovedOperations)
+{
+	size_t removed{};
+
+	CHECK(filter("q /Im1 Do Q", 64, &removed) == "q  Q");
+	CHECK(removed == 1);
+	CHECK(filter("/Sh1 sh\n/GS1 gs\nBT ET", 64, &removed) == "\n\nBT ET");
+	CHECK(removed == 2);
+	CHECK(filtersTo("1 0 0 1 0 0 cm /Im1 Do", "1 0 0 1 0 0 cm "));
+}
+
+TEST_CASE(KeepsOtherOperations)
+{
+	size_t removed{};
+
+	// Other names, longer names sharing a prefix, other operators and other operand lists
+	CHECK(filtersTo("/Im2 Do", "/Im2 Do"));
+	CHECK(filtersTo("/Im10 Do", "/Im10 Do"));
+	CHECK(filtersTo("/Im1 cs", "/Im1 cs"));
+	CHECK(filtersTo("/Im1 Dox", "/Im1 Dox"));
+	CHECK(filtersTo("/Im1 /Im1 Do", "/Im1 /Im1 Do"));
+	CHECK(filtersTo("1 /Im1 Do", "1 /Im1 Do"));
+	CHECK(filter("/Im2 Do /Im1 cs", 64, &removed) == "/Im2 Do /Im1 cs");
+	CHECK(removed == 0);
+}
+
+TEST_CASE(OperationsAcrossChunks)
+{
+	// Every split point, including inside the name and the operator
+	CHECK(filtersTo("q\n/Im1\nDo\nQ\n/Im1 Do", "q\n\nQ\n"));
+	CHECK(filtersTo("/Im1%comment\nDo", ""));
+	CHECK(filtersTo("/Im1 Do/Sh1 sh", ""));
+
+	// An operation cut off by the end is kept
+	CHECK(filtersTo("q /Im1", "q /Im1"));
+	CHECK(filtersTo("q /Im1 D", "q /Im1 D"));
+}
+
+TEST_CASE(InlineImages)
+{
+	string image = "BI /W 1 /H 1 /BPC 8 ID \x01/Im1 Do EIx\xff EI ";
+
+	CHECK(filtersTo(image + "/Im1 Do Q", image + " Q"));
+	CHECK(filtersTo(image, image));
+}
+
+TEST_CASE(StringsAndComments)
+{
+	CHECK(filtersTo("(/Im1 Do) Tj", "(/Im1 Do) Tj"));
+	CHECK(filtersTo("(a\\) /Im1 Do) Tj", "(a\\) /Im1 Do) Tj"));
+	CHECK(filtersTo("(a (/Im1 Do) b) Tj /Im1 Do", "(a (/Im1 Do) b) Tj "));
+	CHECK(filtersTo("<2F496D3120446F> Tj /Im1 Do", "<2F496D3120446F> Tj "));
+	CHECK(filtersTo("<< /Im1 Do >> BDC /Im1 Do", "<< /Im1 Do >> BDC "));
+	CHECK(filtersTo("[(x) /Im1 Do] TJ", "[(x) /Im1 Do] TJ"));
+	CHECK(filtersTo("% /Im1 Do\n/Im1 Do", "% /Im1 Do\n"));
+}
+
+TEST_CASE(RewritesFlateStream)
+{
+	PdfMemDocument document{};
+	auto           object  = document.GetObjects()->CreateObject();
+	string         content = "q /Im1 Do Q /Im2 Do";
+
+	// Set() stores the data Flate encoded
+	object->GetStream()->Set(content.data(), static_cast<pdf_long>(content.size()));
+
+	ContentRewriter rewriter(g_names, 6);
+	CHECK(rewriter.Rewrite(object));
+
+	char     *data{};
+	pdf_long length{};
+	object->GetStream()->GetFilteredCopy(&data, &length);
+
+	unique_ptr<char, void (*)(void *)> holder(data, podofo_free);
+	CHECK(string(data, static_cast<size_t>(length)) == "q  Q /Im2 Do");
+	CHECK(object->GetDictionary().GetKeyAsName(PdfName::KeyFilter) == PdfName("FlateDecode"));
+
+	// Nothing is left to drop
+	CHECK(not rewriter.Rewrite(object));
+}
+
+int main()
+{
+	return Test::RunAll();
+}
@@ -0,0 +1,133 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <podofo/podofo.h>
+
+#include "pdf/Inspector.hpp"
+#include "Test.hpp"
+
+using namespace PDF;
+using namespace PoDoFo;
+using namespace std;
+
+static const string g_removedUri{"http://www.example.com/ad"};
+
+static const string g_keptUri{"http://www.other.org/"};
+
+/// Page drawing a named XObject followed by the keyword text, as the cleaner expects
+static PdfPage *createPage(PdfMemDocument &document)
+{
+	auto page = document.CreatePage(PdfPage::CreateStandardPageSize(ePdfPageSize_A4));
+
+	PdfXObject xobject(PdfRect(0, 0, 200, 20), &document);
+	xobject.GetContentsForAppending()->GetStream()->Set("0 0 200 20 re f", 15);
+
+	auto &resources = page->GetResources()->GetDictionary();
+	if (not resources.HasKey("XObject"))
+	{
+		resources.AddKey("XObject", PdfDictionary());
+	}
+	resources.GetKey("XObject")->GetDictionary().AddKey("Kw1", xobject.GetObject()->Reference());
+
+	string content = "q /Kw1 Do Q BT (www.example.com) Tj ET";
+	page->GetContentsForAppending()->GetStream()->Set(content.data(), static_cast<pdf_long>(content.size()));
+	return page;
+}
+
+static PdfObject *createLink(PdfPage *page, PdfMemDocument &document, const string &uri)
+{
+	auto      annotation = page->CreateAnnotation(ePdfAnnotation_Link, PdfRect(40, 100, 200, 20));
+	PdfAction action(ePdfAction_URI, &document);
+	action.SetURI(PdfString(uri));
+	annotation->SetAction(action);
+	return annotation->GetObject();
+}
+
+static string writeDocument(PdfMemDocument &document)
+{
+	stringstream stream{};
+	{
+		PdfOutputDevice device(&stream);
+		document.Write(&device);
+	}
+	return stream.str();
+}
+
+/// Cleans contents and returns the uris of the links left on every page, "?" for a dangling one
+static vector<vector<string>> cleanLinks(const string &contents, const PageSelection &pages)
+{
+	auto      patterns = make_shared<const PatternSet>(vector<string>{"www\\.example\\.com"});
+	Inspector inspector("shared.pdf", contents, patterns);
+	inspector.DeleteAll(pages);
+
+	auto           output = inspector.WriteToBuffer();
+	PdfMemDocument result{};
+	result.LoadFromBuffer(output.data(), static_cast<long>(output.size()));
+
+	vector<vector<string>> links(static_cast<size_t>(result.GetPageCount()));
+
+	for (int pageIndex{}; pageIndex < result.GetPageCount(); ++pageIndex)
+	{
+		auto annotations = result.GetPage(pageIndex)->GetObject()->GetIndirectKey("Annots");
+		if (not annotations)
+		{
+			continue;
+		}
+
+		for (const auto &item : annotations->GetArray())
+		{
+			auto annotation = item.IsReference() ? result.GetObjects()->GetObject(item.GetReference()) : &item;
+			auto action     = annotation ? annotation->GetIndirectKey("A") : nullptr;
+			auto uri        = action ? action->GetIndirectKey("URI") : nullptr;
+
+			links[static_cast<size_t>(pageIndex)].push_back(uri ? uri->GetString().GetStringUtf8() : "?");
+		}
+	}
+	return links;
+}
+
+/// Two pages listing the same matching link, the second one also has its own other link
+static string sharedLinkDocument()
+{
+	PdfMemDocument document{};
+	auto           first  = createPage(document);
+	auto           second = createPage(document);
+	auto           shared = createLink(first, document, g_removedUri);
+
+	createLink(second, document, g_keptUri);
+	second->GetObject()->GetIndirectKey("Annots")->GetArray().push_back(shared->Reference());
+	return writeDocument(document);
+}
+
+TEST_CASE(SharedAnnotationRemovedFromEveryPage)
+{
+	auto links = cleanLinks(sharedLinkDocument(), PageSelection());
+
+	CHECK(links.size() == 2);
+	CHECK(links[0].empty());
+	CHECK(links[1] == vector<string>{g_keptUri});
+}
+
+TEST_CASE(SharedAnnotationKeptForUnselectedPages)
+{
+	auto links = cleanLinks(sharedLinkDocument(), PageSelection("1"));
+
+	// The second page still lists the link, its object must still be there
+	CHECK(links.size() == 2);
+	CHECK(links[0].empty());
+	CHECK((links[1] == vector<string>{g_keptUri, g_removedUri}));
+}
+
+int main()
+{
+	return Test::RunAll();
+}
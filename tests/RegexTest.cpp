@@ -0,0 +1,204 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "pdf/DfaMatcher.hpp"
+#include "pdf/Matcher.hpp"
+#include "pdf/Pattern.hpp"
+#include "pdf/RegexParser.hpp"
+#include "Test.hpp"
+
+using namespace PDF;
+using namespace std;
+
+/// Always goes through the DFA engine, Matcher::Create() would pick the literal ones where it can
+static bool search(string_view pattern, string_view text)
+{
+	auto root = RegexParser(pattern).Parse();
+	return DfaMatcher(*root).Search(text);
+}
+
+TEST_CASE(Precedence)
+{
+	// Alternation binds looser than concatenation
+	CHECK(search("ab|cd", "xxcd"));
+	CHECK(search("^ab|cd$", "abx"));
+	CHECK(search("^ab|cd$", "xcd"));
+	CHECK(not search("^ab|cd$", "xabx"));
+	CHECK(search("a(b|c)d", "acd"));
+	CHECK(not search("a(b|c)d", "ad"));
+
+	// Quantifiers bind tighter than concatenation
+	CHECK(search("^ab*$", "abbb"));
+	CHECK(not search("^ab*$", "abab"));
+	CHECK(search("^(ab)*$", "abab"));
+	CHECK(search("^(?:ab)+c$", "ababc"));
+	CHECK(not search("^(?:ab)+c$", "c"));
+}
+
+TEST_CASE(Classes)
+{
+	CHECK(search("^[a-c]x$", "bx"));
+	CHECK(not search("^[a-c]x$", "dx"));
+	CHECK(search("^[^0-9]$", "a"));
+	CHECK(not search("^[^0-9]$", "5"));
+	CHECK(search("^\\d+$", "2022"));
+	CHECK(search("^[\\w.]+$", "example.com"));
+	CHECK(not search("^[\\w.]+$", "exa mple"));
+	CHECK(search("^a-$", "a-"));
+	CHECK(search("^[a-]$", "-"));
+	CHECK(search("^.$", "x"));
+	CHECK(not search("^.$", "\n"));
+	CHECK(search("\\x41", "A"));
+	CHECK(not search("[]", "anything"));
+}
+
+TEST_CASE(Anchors)
+{
+	CHECK(search("^abc", "abcx"));
+	CHECK(not search("^abc", "xabc"));
+	CHECK(search("abc$", "xabc"));
+	CHECK(not search("abc$", "abcx"));
+	CHECK(search("^$", ""));
+	CHECK(not search("^$", "a"));
+	CHECK(search("", "anything"));
+}
+
+TEST_CASE(BoundedRepeats)
+{
+	CHECK(not search("^a{2,3}$", "a"));
+	CHECK(search("^a{2,3}$", "aa"));
+	CHECK(search("^a{2,3}$", "aaa"));
+	CHECK(not search("^a{2,3}$", "aaaa"));
+	CHECK(search("^a{2}$", "aa"));
+	CHECK(search("^a{2,}$", "aaaaa"));
+	CHECK(not search("^a{2,}$", "a"));
+	CHECK(search("^(ab){1,2}c$", "ababc"));
+	CHECK(not search("^(ab){1,2}c$", "abababc"));
+
+	// Not a quantifier, read as literal text
+	CHECK(search("^a{x}$", "a{x}"));
+}
+
+TEST_CASE(FallbackToNfa)
+{
+	// An 'a' exactly 13 bytes from the end needs 2^13 DFA states
+	auto       root = RegexParser("a[ab]{12}$").Parse();
+	DfaMatcher matcher(*root);
+
+	CHECK(not matcher.HasDfa());
+	CHECK(matcher.Search("bbba" + string(12, 'b')));
+	CHECK(matcher.Search("a" + string(12, 'a')));
+	CHECK(not matcher.Search(string(13, 'b')));
+	CHECK(not matcher.Search("a" + string(11, 'b')));
+
+	auto       small = RegexParser("a[ab]{2}$").Parse();
+	DfaMatcher dfa(*small);
+
+	CHECK(dfa.HasDfa());
+	CHECK(dfa.Search("xabb"));
+	CHECK(not dfa.Search("xbbb"));
+}
+
+/// The last 13 bytes read "a" then twelve of "a" or "b", what a[ab]{12}$ matches
+static bool endsWithAbRun(const string &text)
+{
+	if (text.size() < 13 or text[text.size() - 13] != 'a')
+	{
+		return false;
+	}
+	return text.find_first_not_of("ab", text.size() - 12) == string::npos;
+}
+
+TEST_CASE(LazyDfaAgreesWithNfa)
+{
+	auto         root = RegexParser("a[ab]{12}$").Parse();
+	DfaMatcher   matcher(*root);
+	mt19937      random(7);
+	const string alphabet = "abc";
+
+	CHECK(not matcher.HasDfa());
+
+	// Short texts stay in the cache, long ones flush it and then step the NFA directly
+	for (size_t length : {0, 1, 12, 13, 14, 40, 5000, 200000})
+	{
+		for (int round{}; round < (length > 1000 ? 2 : 20); ++round)
+		{
+			string text(length, 'a');
+			for (auto &c : text)
+			{
+				c = alphabet[random() % (length > 1000 ? 2 : 3)];
+			}
+			CHECK(matcher.Search(text) == endsWithAbRun(text));
+		}
+	}
+}
+
+TEST_CASE(LongTextWithoutDfa)
+{
+	auto       root = RegexParser("a.{1000}$").Parse();
+	DfaMatcher matcher(*root);
+	string     text(1 << 20, 'a');
+	auto       start = chrono::steady_clock::now();
+
+	CHECK(not matcher.HasDfa());
+	CHECK(matcher.Search(text));
+
+	text.assign(1 << 20, 'b');
+	text[text.size() - 1001] = 'a';
+	CHECK(matcher.Search(text));
+
+	text[text.size() - 1001] = 'b';
+	text[text.size() - 1000] = 'a';
+	CHECK(not matcher.Search(text));
+
+	// Every byte used to rebuild and sort the NFA state set, about 95 s for one of these
+	CHECK(chrono::steady_clock::now() - start < chrono::seconds(5));
+}
+
+TEST_CASE(RejectedPatterns)
+{
+	CHECK_THROWS(RegexParser("(a").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("a)").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("*a").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("[a").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("[z-a]").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("a{3,2}").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("a{1001}").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("(a)\\1").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("(?=a)").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("\\bword").Parse(), invalid_argument);
+	CHECK_THROWS(Matcher::Create("a\\"), invalid_argument);
+}
+
+TEST_CASE(ProgramSizeLimit)
+{
+	// Each bound is allowed on its own, together they multiply
+	CHECK_THROWS(RegexParser("((a{1000}){1000}){1000}").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("a{1000}{1000}").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("(a{100}){300}").Parse(), invalid_argument);
+	CHECK_THROWS(RegexParser("(?:[a-z]{1000}x){25}").Parse(), invalid_argument);
+	CHECK_THROWS(PatternSet(vector<string>{"(a{1000}){1000}"}), invalid_argument);
+
+	// Small enough to compile but too large to match without a full DFA
+	CHECK_THROWS(Matcher::Create("a(.{1000}){3}$"), invalid_argument);
+
+	CHECK(RegexParser::ProgramSize(*RegexParser("a{1000}").Parse()) == 1000);
+	CHECK(RegexParser::ProgramSize(*RegexParser("a{2,5}").Parse()) == 8);
+	CHECK(RegexParser::ProgramSize(*RegexParser("(ab)+").Parse()) == 5);
+	CHECK(search("^(a{10}){10}$", string(100, 'a')));
+}
+
+int main()
+{
+	return Test::RunAll();
+}
@@ -0,0 +1,104 @@
+/**
+ *  Copyright (C) 2015-2022
+ *  Author Alvin Ahmadov <alvin.dev.ahmadov@gmail.com>
+ *
+ *  This file is part of pdf_cleaner
+ *  License-Identifier: MIT License
+ *  See README.md for more information.
+ */
+#pragma once
+
+#include <exception>
+#include <iostream>
+#include <vector>
+
+namespace PDF::Test
+{
+	struct Case
+	{
+		const char *name;
+
+		void (*run)();
+	};
+
+	inline std::vector<Case> &Cases()
+	{
+		static std::vector<Case> cases{};
+		return cases;
+	}
+
+	inline int &Failures()
+	{
+		static int failures{};
+		return failures;
+	}
+
+	struct Register
+	{
+		Register(const char *name, void (*run)())
+		{
+			Cases().push_back({name, run});
+		}
+	};
+
+	inline void Fail(const char *file, int line, const char *expression)
+	{
+		std::cerr << file << ':' << line << ": check failed: " << expression << std::endl;
+		++Failures();
+	}
+
+	/// Runs every registered case, the exit status of a test binary
+	inline int RunAll()
+	{
+		for (const auto &testCase : Cases())
+		{
+			int failures = Failures();
+
+			try
+			{
+				testCase.run();
+			}
+			catch (std::exception &e)
+			{
+				std::cerr << testCase.name << ": unexpected exception: " << e.what() << std::endl;
+				++Failures();
+			}
+
+			std::cout << (Failures() == failures ? "[ OK ] " : "[FAIL] ") << testCase.name << std::endl;
+		}
+
+		return Failures() ? 1 : 0;
+	}
+}
+
+#define TEST_CASE(name)                                                 \
+	static void name();                                                 \
+	static const PDF::Test::Register name##Registered(#name, &name);    \
+	static void name()
+
+#define CHECK(expression)                                               \
+	do                                                                  \
+	{                                                                   \
+		if (not (expression))                                           \
+		{                                                               \
+			PDF::Test::Fail(__FILE__, __LINE__, #expression);           \
+		}                                                               \
+	} while (false)
+
+#define CHECK_THROWS(expression, exception)                             \
+	do                                                                  \
+	{                                                                   \
+		bool thrown{};                                                  \
+		try                                                             \
+		{                                                               \
+			(void) (expression);                                        \
+		}                                                               \
+		catch (exception &)                                             \
+		{                                                               \
+			thrown = true;                                              \
+		}                                                               \
+		if (not thrown)                                                 \
+		{                                                               \
+			PDF::Test::Fail(__FILE__, __LINE__, #expression " throws " #exception); \
+		}                                                               \
+	} while (false)